@@ -0,0 +1,126 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// Microbenchmark for the per-block "what changed" scan done in AnagramControlPlugin::run().
+// Compares the old bool array scan against the packed dirty set, for idle and busy blocks.
+
+#include "DistrhoPluginInfo.h"
+#include "DirtySet.hpp"
+
+#include <chrono>
+#include <cstdio>
+
+USE_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static constexpr const uint32_t kActionCount = 5;
+static constexpr const uint32_t kIterations = 10000000;
+
+// stand-in for writeMidiEvent(), keeps the compiler from removing the loops
+static volatile uint32_t sink = 0;
+
+static inline bool emit(const uint32_t index, const int value)
+{
+    sink = sink + index + value;
+    return true;
+}
+
+struct BoolArrays {
+    int values[kParamBindingCount] = {};
+    bool updatedActions[kActionCount] = {};
+    bool updatedParams[kParamBindingCount] = {};
+
+    void mark(const uint32_t index)
+    {
+        updatedParams[index] = true;
+    }
+
+    void process()
+    {
+        for (uint32_t i = 0; i < kActionCount; ++i)
+        {
+            if (! updatedActions[i])
+                continue;
+            if (! emit(i, 0))
+                break;
+            updatedActions[i] = false;
+        }
+
+        for (uint32_t i = 0; i < kParamBindingCount; ++i)
+        {
+            if (! updatedParams[i])
+                continue;
+            if (! emit(i, values[i]))
+                break;
+            updatedParams[i] = false;
+        }
+    }
+};
+
+struct PackedSet {
+    int values[kParamBindingCount] = {};
+    uint32_t pendingActions = 0;
+    DirtySet<kParamBindingCount> updatedParams;
+
+    void mark(const uint32_t index)
+    {
+        updatedParams.set(index);
+    }
+
+    void process()
+    {
+        while (pendingActions != 0)
+        {
+            if (! emit(pendingActions, 0))
+                break;
+            --pendingActions;
+        }
+
+        // same as run(), indexes are only reset once their event was written
+        updatedParams.visit(0, kParamBindingCount, [this](const uint32_t i) -> bool {
+            if (! emit(i, values[i]))
+                return false;
+            updatedParams.reset(i);
+            return true;
+        });
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+template <class Impl>
+static double measure(const uint32_t changesPerBlock)
+{
+    static Impl impl;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t i = 0; i < kIterations; ++i)
+    {
+        for (uint32_t c = 0; c < changesPerBlock; ++c)
+            impl.mark((i * 7 + c * 13) % kParamBindingCount);
+
+        impl.process();
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::nano>(end - start).count() / kIterations;
+}
+
+int main()
+{
+    static constexpr const uint32_t kChanges[] = { 0, 1, 4, 16, kParamBindingCount };
+
+    std::printf("changes,bool_ns_per_block,dirtyset_ns_per_block\n");
+
+    for (const uint32_t changes : kChanges)
+        std::printf("%u,%.2f,%.2f\n", changes, measure<BoolArrays>(changes), measure<PackedSet>(changes));
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
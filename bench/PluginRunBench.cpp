@@ -0,0 +1,183 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// End-to-end benchmark of AnagramControlPlugin::run(), driven by a minimal host without any plugin format around it.
+// Each block includes the control side changes made before it (parameter changes and actions, as a host would do),
+// so numbers represent the full cost of getting a change out as MIDI.
+//
+// usage: anagram-bench-plugin-run [host-capacity] [blocks]
+//   host-capacity: how many events the host accepts per block, defaults to 2048
+//   blocks: number of blocks run for each case, same for all block sizes, defaults to 1000000
+//
+// stderr is silenced while running, so that anything the plugin prints (such as under action storms)
+// does not end up being measured as terminal I/O.
+
+#include "src/DistrhoPlugin.cpp"
+#include "src/DistrhoUtils.cpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+
+USE_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static constexpr const uint32_t kMaxBlockSize = 8192;
+static constexpr const double kSampleRate = 48000.0;
+static constexpr const uint64_t kDefaultBlocks = 1000000;
+
+// how the control side is changing state before each block
+enum Density {
+    kDensityIdle,
+    kDensityFewPots,
+    kDensityAllCCs,
+    kDensityActionStorm,
+};
+
+static constexpr const char* const kDensityNames[] = {
+    "idle",
+    "few_pots",
+    "all_generic_ccs",
+    "action_storm",
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct StubHost {
+    uint32_t capacity;
+    uint32_t written = 0;
+    uint64_t totalWritten = 0;
+
+    explicit StubHost(const uint32_t capacity_)
+        : capacity(capacity_) {}
+
+    static bool writeMidi(void* const ptr, const MidiEvent&)
+    {
+        StubHost* const self = static_cast<StubHost*>(ptr);
+
+        if (self->written == self->capacity)
+            return false;
+
+        ++self->written;
+        ++self->totalWritten;
+        return true;
+    }
+
+    static bool requestParameterValueChange(void*, uint32_t, float)
+    {
+        return true;
+    }
+
+    static bool updateStateValue(void*, const char*, const char*)
+    {
+        return true;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void changeState(PluginExporter& plugin, const Density density, const uint64_t block)
+{
+    const float value = block % 128;
+
+    switch (density)
+    {
+    case kDensityIdle:
+        break;
+    case kDensityFewPots:
+        plugin.setParameterValue(kParamPot1, value);
+        plugin.setParameterValue(kParamPot1 + 1, 127.0f - value);
+        break;
+    case kDensityAllCCs:
+        for (uint32_t i = kParamCCs; i < kParamBindingCount; ++i)
+            plugin.setParameterValue(i, value);
+        break;
+    case kDensityActionStorm:
+        plugin.setState("preset", block % 2 ? "+" : "-");
+        plugin.setState("scene", block % 2 ? "+" : "-");
+        plugin.setState("bank", block % 2 ? "+" : "-");
+        plugin.setState("mode", "1");
+        break;
+    }
+}
+
+static void measure(const Density density,
+                    const bool dinLink,
+                    const uint32_t blockSize,
+                    const uint32_t capacity,
+                    const uint64_t numBlocks)
+{
+    static float buffers[4][kMaxBlockSize];
+    const float* inputs[2] = { buffers[0], buffers[1] };
+    float* outputs[2] = { buffers[2], buffers[3] };
+
+    StubHost host(capacity);
+    PluginExporter plugin(&host,
+                          StubHost::writeMidi,
+                          StubHost::requestParameterValueChange,
+                          StubHost::updateStateValue);
+
+    // no throttling unless asked for, so only the hot path itself is measured
+    plugin.setParameterValue(kParamEventSpacing, dinLink ? 1.0f : 0.0f);
+    plugin.setParameterValue(kParamLinkRate, dinLink ? 31250.0f : 0.0f);
+    plugin.activate();
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint64_t block = 0; block < numBlocks; ++block)
+    {
+        changeState(plugin, density, block);
+        host.written = 0;
+        plugin.run(inputs, outputs, blockSize, nullptr, 0);
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    plugin.deactivate();
+
+    std::printf("%s,%s,%u,%u,%llu,%.1f,%.0f,%.3f\n",
+                kDensityNames[density],
+                dinLink ? "din" : "unlimited",
+                blockSize,
+                capacity,
+                static_cast<unsigned long long>(numBlocks),
+                seconds * 1e9 / numBlocks,
+                host.totalWritten / seconds,
+                static_cast<double>(host.totalWritten) / numBlocks);
+}
+
+int main(int argc, char* argv[])
+{
+    const uint32_t capacity = argc > 1 ? std::atoi(argv[1]) : 2048;
+    const uint64_t numBlocks = argc > 2 ? std::max(1ULL, std::strtoull(argv[2], nullptr, 10)) : kDefaultBlocks;
+
+    d_nextBufferSize = kMaxBlockSize;
+    d_nextSampleRate = kSampleRate;
+
+   #ifdef _WIN32
+    std::freopen("NUL", "w", stderr);
+   #else
+    std::freopen("/dev/null", "w", stderr);
+   #endif
+
+    std::printf("density,link,block_size,host_capacity,blocks,ns_per_block,events_per_s,events_per_block\n");
+
+    for (const Density density : { kDensityIdle, kDensityFewPots, kDensityAllCCs, kDensityActionStorm })
+    {
+        for (const bool dinLink : { false, true })
+        {
+            for (const uint32_t blockSize : { 1u, 16u, 64u, 256u, 1024u, 8192u })
+                measure(density, dinLink, blockSize, capacity, numBlocks);
+        }
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
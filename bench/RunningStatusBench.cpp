@@ -0,0 +1,121 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// Byte count and throughput of the running status encoder for typical automation bursts,
+// compared against sending every message with its full status byte.
+
+#include "DistrhoPluginInfo.h"
+#include "RunningStatusEncoder.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <vector>
+
+USE_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Message {
+    uint8_t data[3];
+    uint8_t size;
+};
+
+// all generic CCs changing at once, as on a host session load
+static std::vector<Message> genericBurst()
+{
+    std::vector<Message> msgs;
+    for (const uint8_t cc : kAllowedCCs)
+        msgs.push_back({ { 0xB0, cc, 64 }, 3 });
+    return msgs;
+}
+
+// all 6 pots swept together through their full range
+static std::vector<Message> potSweep()
+{
+    std::vector<Message> msgs;
+    for (uint8_t value = 0; value < 128; ++value)
+        for (uint8_t pot = 0; pot < 6; ++pot)
+            msgs.push_back({ { 0xB0, static_cast<uint8_t>(20 + pot), value }, 3 });
+    return msgs;
+}
+
+// preset changes, each followed by a handful of CCs to set up the new preset
+static std::vector<Message> presetSetup()
+{
+    std::vector<Message> msgs;
+    for (uint8_t preset = 0; preset < 16; ++preset)
+    {
+        msgs.push_back({ { 0xC0, preset, 0 }, 2 });
+        for (uint8_t i = 0; i < 8; ++i)
+            msgs.push_back({ { 0xB0, kAllowedCCs[i], preset }, 3 });
+    }
+    return msgs;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static void measure(const char* const name, const std::vector<Message>& msgs, const uint32_t blockSize)
+{
+    static constexpr const uint32_t kIterations = 20000;
+
+    std::vector<uint8_t> stream(msgs.size() * 3);
+    RunningStatusEncoder encoder;
+    uint32_t fullBytes = 0;
+    uint32_t encodedBytes = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for (uint32_t it = 0; it < kIterations; ++it)
+    {
+        encoder.reset();
+        fullBytes = encodedBytes = 0;
+
+        for (size_t i = 0; i < msgs.size(); ++i)
+        {
+            // restart running status at block boundaries
+            if (blockSize != 0 && i % blockSize == 0)
+                encoder.reset();
+
+            fullBytes += msgs[i].size;
+            encodedBytes += encoder.encode(msgs[i].data, msgs[i].size, stream.data() + encodedBytes);
+        }
+    }
+
+    const auto end = std::chrono::steady_clock::now();
+    const double seconds = std::chrono::duration<double>(end - start).count();
+
+    std::printf("%s,%u,%zu,%u,%u,%.1f,%.2f,%.2f,%.1f\n",
+                name,
+                blockSize,
+                msgs.size(),
+                fullBytes,
+                encodedBytes,
+                100.0 - 100.0 * encodedBytes / fullBytes,
+                fullBytes / 3125.0 * 1000.0,
+                encodedBytes / 3125.0 * 1000.0,
+                static_cast<double>(fullBytes) * kIterations / seconds / 1e6);
+}
+
+int main()
+{
+    const std::vector<Message> generic = genericBurst();
+    const std::vector<Message> pots = potSweep();
+    const std::vector<Message> presets = presetSetup();
+
+    // block size here is in messages, 0 means a single continuous stream
+    std::printf("burst,msgs_per_block,messages,full_bytes,rs_bytes,saved_pct,full_din_ms,rs_din_ms,encode_mb_per_s\n");
+
+    for (const uint32_t blockSize : { 0u, 16u, 4u })
+    {
+        measure("generic_ccs", generic, blockSize);
+        measure("pot_sweep", pots, blockSize);
+        measure("preset_setup", presets, blockSize);
+    }
+
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
@@ -5,6 +5,20 @@
  */
 
 #include "DistrhoPlugin.hpp"
+#include "extra/Base64.hpp"
+#include "CommandQueue.hpp"
+#include "CommandScript.hpp"
+#include "DirtySet.hpp"
+#include "EventScheduler.hpp"
+#include "Handoff.hpp"
+#include "HiResEncoder.hpp"
+#include "KeyDispatch.hpp"
+#include "LatencyHistogram.hpp"
+#include "ParameterRamp.hpp"
+#include "RealtimeStats.hpp"
+#include "RunningStatusEncoder.hpp"
+#include "StressGenerator.hpp"
+#include "Timeline.hpp"
 
 #include <algorithm>
 
@@ -12,22 +26,307 @@ START_NAMESPACE_DISTRHO
 
 // --------------------------------------------------------------------------------------------------------------------
 
-enum Actions {
-    kActionBank,
-    kActionPreset,
-    kActionScene,
-    kActionMode,
-    kActionTuner,
-    kActionCount
+// bindings grouped by priority, a group is only sent after all groups before it are empty
+static constexpr const struct {
+    uint32_t first, last;
+} kBindingPriorities[] = {
+    { kParamFoot1, kParamFoot3 + 1 },
+    { kParamPot1, kParamPot6 + 1 },
+    { kParamExpPedal, kParamExpPedal + 1 },
+    { kParamCCs, kParamBindingCount },
+};
+
+// bindings that can be sent in high resolution, all within the range before kParamCCs
+static constexpr bool isHiResBinding(const uint32_t index) noexcept
+{
+    return index <= kParamPot6 || index == kParamExpPedal;
+}
+
+// CCs that a high resolution mode uses for its own messages, LSBs of the pots or NRPN selection and data entry
+// generic bindings on these CCs would clash with them, so they are neither sent nor taken as feedback meanwhile
+static constexpr bool isHiResReservedCC(const uint32_t mode, const uint8_t cc) noexcept
+{
+    switch (mode)
+    {
+    case HiResEncoder::kModeCC:
+        return cc >= 32 && cc < 64 && kCCToParam[cc - 32] != kCCUnbound && isHiResBinding(kCCToParam[cc - 32]);
+    case HiResEncoder::kModeNRPN:
+        return cc == 6 || cc == 38 || cc == 98 || cc == 99;
+    default:
+        return false;
+    }
+}
+
+static_assert(isHiResReservedCC(HiResEncoder::kModeCC, 52) && isHiResReservedCC(HiResEncoder::kModeCC, 57),
+              "pot LSBs must be reserved in 14-bit CC mode");
+static_assert(! isHiResReservedCC(HiResEncoder::kModeCC, 58) && ! isHiResReservedCC(HiResEncoder::kModeOff, 52),
+              "only pot LSBs must be reserved in 14-bit CC mode");
+
+// binding state is kept per unit in slots, laid out binding-major so that a range of bindings covers all units at once
+static constexpr uint32_t getSlot(const uint32_t index, const uint32_t unit) noexcept
+{
+    return index * kMaxUnits + unit;
+}
+
+static constexpr const uint32_t kSlotCount = kParamBindingCount * kMaxUnits;
+
+// high resolution bindings are all within the range before kParamCCs, and so are their slots
+static constexpr const uint32_t kHiResSlotCount = kParamCCs * kMaxUnits;
+
+// from parameter values into 14-bit, so that 127 maps to the highest value
+static constexpr const float kHiResScale = HiResEncoder::kMaxValue / 127.0f;
+
+// how often ramping bindings are looked at, in ms, only changes of their quantized value are sent
+static constexpr const double kRampInterval = 1.0;
+
+// keys handled by setState(), besides actions
+enum StateKeys {
+    kStateTimeline,
+    kStateTimelineSave,
+    kStateTimelineLoad,
+    kStateTimelineStream,
+    kStateScript,
+    kStateScriptLoad,
+    kStateResync,
+    kStateCommands,
+    kStateSnapshotStore,
+    kStateSnapshotRecall,
+    kStateSnapshotMorph,
+    kStateFullState,
+    kStateKeyCount
+};
+
+static constexpr const char* const kStateNames[] = {
+    "timeline",
+    "timeline_save",
+    "timeline_load",
+    "timeline_stream",
+    "script",
+    "script_load",
+    "resync",
+    "cmds",
+    "snapshot_store",
+    "snapshot_recall",
+    "snapshot_morph",
+    "full_state",
+};
+static_assert(std::size(kStateNames) == kStateKeyCount, "wrong number of state names");
+
+static constexpr const KeyDispatch<kStateKeyCount> kStateKeys(kStateNames);
+static_assert(kStateKeys.isValid(), "no perfect hash for state names");
+
+// most commands in a single "cmds" batch, all of them must fit in the pending actions at once
+static constexpr const uint32_t kMaxBatchSize = 64;
+
+// timeline commands, also the values of kParamTimelineState
+enum TimelineOps {
+    kTimelineStop,
+    kTimelineRecord,
+    kTimelinePlay,
+    kTimelineLoaded,
+    kTimelineStreamed, // next window of a streamed timeline
+};
+
+// script commands, also the values of kParamScriptState
+enum ScriptOps {
+    kScriptStop,
+    kScriptPlay,
+    kScriptLoaded,
+};
+
+// snapshot commands
+enum SnapshotOps {
+    kSnapshotStore,
+    kSnapshotRecall,
+    kSnapshotMorph,
+};
+
+// last known bank, preset, scene and mode of each unit, indexed by action
+static constexpr const uint32_t kLocationCount = kActionTuner;
+
+// order in which locations are sent back, scenes only work once the mode allows them
+static constexpr const uint8_t kLocationOrder[] = { kActionMode, kActionBank, kActionPreset, kActionScene };
+static_assert(std::size(kLocationOrder) == kLocationCount, "wrong number of locations");
+
+// full state blob, "AMFS" and version, mask of stored snapshots, then bindings of all units, locations and snapshots
+static constexpr const char kFullStateMagic[4] = { 'A', 'M', 'F', 'S' };
+static constexpr const uint8_t kFullStateVersion = 1;
+static constexpr const uint32_t kFullStateHeaderSize = sizeof(kFullStateMagic) + 1 + 2;
+
+// bindings take a single byte each, 2 for 14-bit values of high resolution ones
+static constexpr uint32_t getBindingsSize() noexcept
+{
+    uint32_t size = 0;
+    for (uint32_t i = 0; i < kParamBindingCount; ++i)
+        size += isHiResBinding(i) ? 2 : 1;
+    return size;
+}
+
+static constexpr const uint32_t kFullStateMaxSize = kFullStateHeaderSize
+                                                  + kMaxUnits * (getBindingsSize() + kLocationCount)
+                                                  + kSnapshotCount * getBindingsSize();
+
+// enough for a few hours of heavy use, memory is only touched as events are recorded
+static constexpr const uint32_t kTimelineCapacity = 1 << 20;
+
+// streamed timelines are played through a window of this many events, moved along by half of it at a time
+static constexpr const uint32_t kTimelineStreamWindow = 1 << 14;
+
+// round-trip latency probes
+enum ProbeModes {
+    kProbeOff,
+    kProbeScene,
+    kProbeCC,
+    kProbeModeCount
+};
+
+// generic CC used for probing, the last one as it is the least likely to be mapped to anything
+// the value set by the user is sent again once each probe is done with
+static constexpr const uint32_t kProbeParam = kParamBindingCount - 1;
+
+// time to wait for an answer before considering a probe lost
+static constexpr const double kProbeTimeout = 1.0;
+
+// which incoming events are passed through
+struct ThruFilter {
+    uint8_t channel; // 1-16, 0 for all
+    uint8_t firstCC;
+    uint8_t lastCC;
+    bool override;
+};
+
+// an action waiting to be sent, along with the frame it was received on
+struct PendingAction {
+    Command command;
+    uint64_t frame;
+};
+
+// how units are paced on the single output port, also the values of kParamOutputRouting
+// there are no extra ports, "per unit" only paces each channel as if the output was split by channel downstream
+enum OutputRouting {
+    kRoutingSingle,  // all units share a single link
+    kRoutingPerUnit, // each unit is paced as if on a link of its own
+    kRoutingCount
+};
+
+// pacing and pending actions of a link, so that a busy link does not hold back the others, all of them share the output port
+struct OutputRoute {
+    EventScheduler scheduler;
+    RunningStatusEncoder encoder;
+    CommandFifo<PendingAction, 256> pendingActions;
 };
 
 class AnagramControlPlugin : public Plugin
 {
-    int params[kParamCount] = {};
-    bool updatedParams[kParamCount] = {};
+    // control side, written by the host and read from any thread, bindings in slots (see getSlot)
+    std::atomic<int> params[kSlotCount] = {};
+    std::atomic<int> hiResParams[kHiResSlotCount] = {};
+    std::atomic<float> extraParams[kParamCount - kParamBindingCount] = {};
+    std::atomic<bool> paramsOverflowed { false };
+
+    // values received from the device and requested as parameter changes, so they are not sent back to it
+    std::atomic<int> feedbackParams[kSlotCount];
+
+    // everything sent from control side into the realtime one
+    CommandQueue<Command, 1024> commands;
+
+    // timelines handed over between control and realtime sides
+    Handoff<Timeline> timelines;
+
+    // streamed timeline, control side only, the window is the last one published
+    Timeline::Reader timelineReader;
+    const Timeline* timelineWindow = nullptr;
+
+    // index of the next timeline event to play within the whole file, written on the realtime side
+    std::atomic<uint64_t> timelinePlayed { 0 };
+
+    // compiled scripts, same as above
+    Handoff<CommandScript> scripts;
+
+    // realtime side, only touched by run(), bindings in slots as above
+    int pendingParams[kSlotCount] = {};
+    ParameterRamp ramps[kHiResSlotCount]; // in 14-bit, only for high resolution bindings
+    DirtySet<kHiResSlotCount> activeRamps;
+    DirtySet<kSlotCount> updatedParams;
+    OutputRoute routes[kMaxUnits]; // only the first one unless routing per unit
+    uint32_t routing = kRoutingSingle;
+    uint32_t blockedRoutes = 0; // routes with no room left in this block, as bits
+    uint32_t lastFrame = 0; // of the last event written in this block, as output must stay in order
+    bool useRunningStatus = false;
+    HiResEncoder hiResEncoders[kMaxUnits]; // one per channel
+    uint32_t hiResMode = HiResEncoder::kModeOff;
+    uint32_t unitCount = 1;
+    uint32_t selectedUnit = 0;
+    uint64_t frameCounter = 0;
+    uint32_t maxActionLatency = 0;
+    uint64_t framesSinceResync = 0;
+    int lastSentParams[kSlotCount]; // what the device has, -1 for unknown
+    RealtimeStats stats;
+
+    // midi thru, only valid during run()
+    ThruFilter thruFilter = {};
+    const MidiEvent* thruEvents = nullptr;
+    uint32_t thruEventCount = 0;
+    uint32_t thruIndex = 0;
+    DirtySet<kSlotCount> thruConflicts;
+
+    // timeline recording and playback
+    Timeline* timeline = nullptr;
+    uint32_t timelineMode = kTimelineStop;
+    uint32_t timelineIndex = 0;
+    uint64_t timelineFrame = 0;
+
+    // snapshots, values are 14-bit for high resolution bindings, written on the realtime side and read from any thread
+    std::atomic<int> snapshots[kSnapshotCount][kParamBindingCount] = {};
+    std::atomic<bool> snapshotStored[kSnapshotCount] = {};
+
+    // device locations, -1 for unknown, kept from what was sent and received and read from any thread
+    std::atomic<int> locations[kMaxUnits][kLocationCount];
+
+    // full state restored on the control side, for the realtime one to send it all
+    std::atomic<bool> stateRestored { false };
+    bool resendPending = false;
+
+    // host binding writes are part of a restore until the next block, see setParameterValue
+    std::atomic<bool> restoringBindings { false };
+
+    // morph between 2 snapshots, only for bindings without a ramp, high resolution ones use ramps instead
+    DirtySet<kParamBindingCount> morphBindings;
+    uint32_t morphFrom = 0;
+    uint32_t morphTo = 0;
+    uint8_t morphUnit = 0;
+    uint64_t morphFrames = 0;
+    uint64_t morphElapsed = 0;
+
+    // script playback, due is the frame of the next event relative to the start of the block
+    const CommandScript* script = nullptr;
+    bool scriptPlaying = false;
+    bool scriptDelayed = false;
+    uint32_t scriptIndex = 0;
+    double scriptDue = 0.0;
 
-    int8_t actions[kActionCount] = {};
-    bool updatedActions[kActionCount] = {};
+    // stress generator, phase is the frame of the next message relative to the start of the block
+    StressGenerator stressGenerator;
+    double stressPhase = 0.0;
+    uint32_t stressSent = 0;
+    uint32_t stressMissed = 0;
+    uint32_t stressWindow = 0;
+    DirtySet<kSlotCount> stressBindings; // changed by the generator, set back to the user values once it stops
+
+    // latency probe, frames are absolute (see frameCounter)
+    LatencyHistogram<1000, 100> probeLatencies; // up to 100ms
+    static_assert(1000 * 100 == kProbeHistogramBins * kProbeHistogramBinWidth, "probe histogram ranges must match");
+    uint32_t probeMode = kProbeOff;
+    uint32_t probeTag = 0;
+    uint32_t probeLost = 0;
+    uint8_t probeStatus = 0;
+    uint8_t probeCC = 0;
+    uint8_t probeValue = 0;
+    uint8_t probeUnit = 0;
+    bool probeWaiting = false;
+    uint64_t probeSentFrame = 0;
+    uint64_t probeBlockEnd = 0;
+    uint64_t probeNextFrame = 0;
 
 public:
    /**
@@ -35,10 +334,35 @@ public:
       You must set all parameter values to their defaults, matching ParameterRanges::def.
     */
     AnagramControlPlugin()
-        : Plugin(kParamCount, 0, 0) // parameters, programs, states
+        : Plugin(kParamCount, 0, 1) // parameters, programs, states
     {
-        for (int i = kParamPot1; i <= kParamPot6; ++i)
-            params[i] = 63;
+        for (uint32_t unit = 0; unit < kMaxUnits; ++unit)
+        {
+            for (uint32_t i = 0; i < kLocationCount; ++i)
+                locations[unit][i].store(-1, std::memory_order_relaxed);
+        }
+
+        for (uint32_t unit = 0; unit < kMaxUnits; ++unit)
+        {
+            for (uint32_t i = kParamPot1; i <= kParamPot6; ++i)
+            {
+                params[getSlot(i, unit)].store(63, std::memory_order_relaxed);
+                hiResParams[getSlot(i, unit)].store(63 * kHiResScale, std::memory_order_relaxed);
+            }
+        }
+
+        for (uint32_t i = 0; i < kSlotCount; ++i)
+        {
+            feedbackParams[i].store(-1, std::memory_order_relaxed);
+            lastSentParams[i] = -1;
+        }
+
+        for (uint32_t i = kParamBindingCount; i < kParamCount; ++i)
+        {
+            Parameter parameter;
+            initParameter(i, parameter);
+            extraParams[i - kParamBindingCount].store(parameter.ranges.def, std::memory_order_relaxed);
+        }
     }
 
 protected:
@@ -105,6 +429,7 @@ protected:
         switch (index)
         {
         case kParamPot1 ... kParamPot6:
+            parameter.hints = kParameterIsAutomatable;
             parameter.ranges.def = 63.0f;
             parameter.name = "Pot " + String(index + 1);
             parameter.symbol = "pot" + String(index + 1);
@@ -116,18 +441,477 @@ protected:
             parameter.symbol = "foot" + String(index - kParamFoot1 + 1);
             break;
         case kParamExpPedal:
+            parameter.hints = kParameterIsAutomatable;
             parameter.ranges.def = 0.0f;
             parameter.name = "Exp.Pedal";
             parameter.symbol = "exp_pedal";
             break;
-        case kParamCCs ... kParamCount - 1:
+        case kParamCCs ... kParamBindingCount - 1:
             parameter.ranges.def = 0.0f;
-            parameter.name = "CC " + String(kAllowedCCs[index - kParamCCs]);
-            parameter.symbol = "cc" + String(kAllowedCCs[index - kParamCCs]);
+            parameter.name = "CC " + String(kParamToCC[index]);
+            parameter.symbol = "cc" + String(kParamToCC[index]);
+            break;
+        case kParamEventSpacing:
+            parameter.hints = 0x0;
+            parameter.ranges.def = 1.0f;
+            parameter.ranges.max = 10.0f;
+            parameter.name = "Event Spacing";
+            parameter.symbol = "event_spacing";
+            parameter.unit = "ms";
+            parameter.description = "Minimum time between consecutive MIDI events";
+            break;
+        case kParamLinkRate:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.def = 31250.0f;
+            parameter.ranges.max = 1000000.0f;
+            parameter.name = "Link Rate";
+            parameter.symbol = "link_rate";
+            parameter.unit = "baud";
+            parameter.description = "Bandwidth of the physical MIDI link, 31250 for DIN, 0 for unlimited";
+            break;
+        case kParamRunningStatus:
+            parameter.hints = kParameterIsBoolean | kParameterIsInteger;
+            parameter.ranges.max = 1.0f;
+            parameter.name = "Running Status";
+            parameter.symbol = "running_status";
+            parameter.description = "Account for MIDI running status on the link, repeated status bytes are not sent";
+            break;
+        case kParamHiResMode:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.max = HiResEncoder::kModeCount - 1;
+            parameter.name = "High Resolution";
+            parameter.symbol = "hires_mode";
+            parameter.description = "Send pots and expression pedal with 14-bit resolution, "
+                                    "as CC pairs (pots only, CC 52-57 as LSB) or as NRPN 0:CC (CC 6, 38, 98 and 99), "
+                                    "generic CCs on the controllers used for this are not sent nor received meanwhile";
+            parameter.enumValues.count = HiResEncoder::kModeCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[HiResEncoder::kModeCount];
+                values[0].label = "Off";
+                values[0].value = HiResEncoder::kModeOff;
+                values[1].label = "14-bit CC";
+                values[1].value = HiResEncoder::kModeCC;
+                values[2].label = "NRPN";
+                values[2].value = HiResEncoder::kModeNRPN;
+                parameter.enumValues.values = values;
+            }
+            break;
+        case kParamSmoothing:
+            parameter.hints = 0x0;
+            parameter.ranges.max = 1000.0f;
+            parameter.name = "Smoothing";
+            parameter.symbol = "smoothing";
+            parameter.unit = "ms";
+            parameter.description = "Time for pots and expression pedal to glide into a new value, 0 for instant changes";
+            break;
+        case kParamMorphTime:
+            parameter.hints = 0x0;
+            parameter.ranges.def = 1000.0f;
+            parameter.ranges.max = 60000.0f;
+            parameter.name = "Morph Time";
+            parameter.symbol = "morph_time";
+            parameter.unit = "ms";
+            parameter.description = "Time taken to morph from one snapshot into another";
+            break;
+        case kParamResyncInterval:
+            parameter.hints = 0x0;
+            parameter.ranges.max = 3600.0f;
+            parameter.name = "Resync Interval";
+            parameter.symbol = "resync_interval";
+            parameter.unit = "s";
+            parameter.description = "Periodically send the locations and all bindings again, in case the device lost them, 0 for never";
+            break;
+        case kParamResendOnActivate:
+            parameter.hints = kParameterIsBoolean | kParameterIsInteger;
+            parameter.ranges.max = 1.0f;
+            parameter.name = "Resend On Activate";
+            parameter.symbol = "resend_on_activate";
+            parameter.description = "Send the last bank, preset, scene, mode and all bindings when the plugin is activated, "
+                                    "so that a reloaded session brings the device back to its saved state";
+            break;
+        case kParamUnitCount:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.def = 1.0f;
+            parameter.ranges.min = 1.0f;
+            parameter.ranges.max = kMaxUnits;
+            parameter.name = "Units";
+            parameter.symbol = "unit_count";
+            parameter.description = "Number of units controlled, one per MIDI channel starting from channel 1";
+            break;
+        case kParamUnit:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.def = 1.0f;
+            parameter.ranges.min = 1.0f;
+            parameter.ranges.max = kMaxUnits;
+            parameter.name = "Selected Unit";
+            parameter.symbol = "unit";
+            parameter.description = "Unit that binding parameters, actions and device reports refer to, as its MIDI channel";
+            break;
+        case kParamOutputRouting:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.max = kRoutingCount - 1;
+            parameter.name = "Output Routing";
+            parameter.symbol = "output_routing";
+            parameter.description = "Pace each unit as if on a link of its own, for when the output is split by channel "
+                                    "outside of the plugin, so that a busy or slow link does not hold back the others. "
+                                    "There is still a single MIDI output port";
+            parameter.enumValues.count = kRoutingCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[kRoutingCount];
+                parameter.enumValues.values = values;
+                values[0].label = "Shared Link";
+                values[0].value = kRoutingSingle;
+                values[1].label = "Link Per Unit";
+                values[1].value = kRoutingPerUnit;
+            }
+            break;
+        case kParamThru:
+            parameter.hints = kParameterIsBoolean | kParameterIsInteger;
+            parameter.ranges.max = 1.0f;
+            parameter.name = "MIDI Thru";
+            parameter.symbol = "thru";
+            parameter.description = "Merge incoming MIDI into the output";
+            break;
+        case kParamThruChannel:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.max = 16.0f;
+            parameter.name = "Thru Channel";
+            parameter.symbol = "thru_channel";
+            parameter.description = "Only pass channel messages from this channel, 0 for all";
+            break;
+        case kParamThruFirstCC:
+            parameter.hints = kParameterIsInteger;
+            parameter.name = "Thru First CC";
+            parameter.symbol = "thru_first_cc";
+            parameter.description = "Lowest CC number passed through";
+            break;
+        case kParamThruLastCC:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.def = 127.0f;
+            parameter.name = "Thru Last CC";
+            parameter.symbol = "thru_last_cc";
+            parameter.description = "Highest CC number passed through";
+            break;
+        case kParamThruOverride:
+            parameter.hints = kParameterIsBoolean | kParameterIsInteger;
+            parameter.ranges.def = 1.0f;
+            parameter.ranges.max = 1.0f;
+            parameter.name = "Thru Override";
+            parameter.symbol = "thru_override";
+            parameter.description = "Drop incoming CCs for controllers we are also sending in the same block";
+            break;
+        case kParamTimelineSync:
+            parameter.hints = kParameterIsBoolean | kParameterIsInteger;
+            parameter.ranges.def = 1.0f;
+            parameter.ranges.max = 1.0f;
+            parameter.name = "Timeline Sync";
+            parameter.symbol = "timeline_sync";
+            parameter.description = "Record and play the timeline following the host transport instead of free-running";
+            break;
+        case kParamStressMode:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.max = kStressModeCount - 1;
+            parameter.name = "Stress Mode";
+            parameter.symbol = "stress_mode";
+            parameter.description = "Generate a stream of messages for load-testing the device";
+            parameter.enumValues.count = kStressModeCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[kStressModeCount];
+                parameter.enumValues.values = values;
+                values[0].label = "Off";
+                values[0].value = kStressOff;
+                values[1].label = "CC Sweep";
+                values[1].value = kStressSweep;
+                values[2].label = "Increment Storm";
+                values[2].value = kStressStorm;
+                values[3].label = "Random Mix";
+                values[3].value = kStressRandom;
+            }
+            break;
+        case kParamStressRate:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.def = 100.0f;
+            parameter.ranges.min = 1.0f;
+            parameter.ranges.max = 10000.0f;
+            parameter.name = "Stress Rate";
+            parameter.symbol = "stress_rate";
+            parameter.unit = "msg/s";
+            parameter.description = "Requested rate of generated messages, event spacing and link rate still apply";
+            break;
+        case kParamStressSeed:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.def = 1.0f;
+            parameter.ranges.max = 65535.0f;
+            parameter.name = "Stress Seed";
+            parameter.symbol = "stress_seed";
+            parameter.description = "Seed for the generated messages, the same seed always gives the same stream";
+            break;
+        case kParamProbeMode:
+            parameter.hints = kParameterIsInteger;
+            parameter.ranges.max = kProbeModeCount - 1;
+            parameter.name = "Probe Mode";
+            parameter.symbol = "probe_mode";
+            parameter.description = "Periodically send a message and measure how long the device takes to answer it";
+            parameter.enumValues.count = kProbeModeCount;
+            parameter.enumValues.restrictedMode = true;
+            {
+                ParameterEnumerationValue* const values = new ParameterEnumerationValue[kProbeModeCount];
+                parameter.enumValues.values = values;
+                values[0].label = "Off";
+                values[0].value = kProbeOff;
+                values[1].label = "Scene";
+                values[1].value = kProbeScene;
+                values[2].label = "Generic CC";
+                values[2].value = kProbeCC;
+            }
+            break;
+        case kParamProbeInterval:
+            parameter.hints = 0x0;
+            parameter.ranges.def = 500.0f;
+            parameter.ranges.min = 50.0f;
+            parameter.ranges.max = 5000.0f;
+            parameter.name = "Probe Interval";
+            parameter.symbol = "probe_interval";
+            parameter.unit = "ms";
+            parameter.description = "Time between latency probes";
+            break;
+        case kParamActionLatency:
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.max = 1000.0f;
+            parameter.name = "Action Latency";
+            parameter.symbol = "action_latency";
+            parameter.unit = "ms";
+            parameter.description = "Highest time an action had to wait before being sent";
+            break;
+        case kParamDeviceBank:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.name = "Device Bank";
+            parameter.symbol = "device_bank";
+            parameter.description = "Last bank reported by the device";
+            break;
+        case kParamDevicePreset:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.name = "Device Preset";
+            parameter.symbol = "device_preset";
+            parameter.description = "Last preset reported by the device";
+            break;
+        case kParamDeviceScene:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 3.0f;
+            parameter.name = "Device Scene";
+            parameter.symbol = "device_scene";
+            parameter.description = "Last scene reported by the device";
+            break;
+        case kParamDeviceMode:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 2.0f;
+            parameter.name = "Device Mode";
+            parameter.symbol = "device_mode";
+            parameter.description = "Last mode reported by the device";
+            break;
+        case kParamTimelineState:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 2.0f;
+            parameter.name = "Timeline State";
+            parameter.symbol = "timeline_state";
+            parameter.description = "Timeline stopped, recording or playing";
+            break;
+        case kParamTimelineEvents:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = kTimelineCapacity;
+            parameter.name = "Timeline Events";
+            parameter.symbol = "timeline_events";
+            parameter.description = "Number of events in the timeline";
+            break;
+        case kParamTimelinePosition:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = kTimelineCapacity;
+            parameter.name = "Timeline Position";
+            parameter.symbol = "timeline_position";
+            parameter.description = "Index of the next timeline event to be played";
+            break;
+        case kParamScriptState:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 1.0f;
+            parameter.name = "Script State";
+            parameter.symbol = "script_state";
+            parameter.description = "Script stopped or playing";
+            break;
+        case kParamScriptEvents:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 16777216.0f;
+            parameter.name = "Script Events";
+            parameter.symbol = "script_events";
+            parameter.description = "Number of events in the loaded script";
+            break;
+        case kParamScriptPosition:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 16777216.0f;
+            parameter.name = "Script Position";
+            parameter.symbol = "script_position";
+            parameter.description = "Index of the next script event to be played";
+            break;
+        case kParamStressAchievedRate:
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.max = 10000.0f;
+            parameter.name = "Stress Achieved Rate";
+            parameter.symbol = "stress_achieved_rate";
+            parameter.unit = "msg/s";
+            parameter.description = "Rate of generated messages actually sent";
+            break;
+        case kParamStressMissedRate:
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.max = 10000.0f;
+            parameter.name = "Stress Missed Rate";
+            parameter.symbol = "stress_missed_rate";
+            parameter.unit = "msg/s";
+            parameter.description = "Rate of generated messages dropped for lack of bandwidth or block space";
+            break;
+        case kParamProbeLastLatency:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 192000.0f;
+            parameter.name = "Probe Last Latency";
+            parameter.symbol = "probe_last_latency";
+            parameter.unit = "samples";
+            parameter.description = "Round-trip latency of the last answered probe";
+            break;
+        case kParamProbeMin:
+        case kParamProbeMedian:
+        case kParamProbeP99:
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.max = 100000.0f;
+            parameter.unit = "us";
+            switch (index)
+            {
+            case kParamProbeMin:
+                parameter.name = "Probe Min Latency";
+                parameter.symbol = "probe_min";
+                parameter.description = "Lowest round-trip latency measured";
+                break;
+            case kParamProbeMedian:
+                parameter.name = "Probe Median Latency";
+                parameter.symbol = "probe_median";
+                parameter.description = "Median round-trip latency measured";
+                break;
+            case kParamProbeP99:
+                parameter.name = "Probe P99 Latency";
+                parameter.symbol = "probe_p99";
+                parameter.description = "Round-trip latency under which 99% of the probes were answered";
+                break;
+            }
+            break;
+        case kParamProbeCount:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 1000000.0f;
+            parameter.name = "Probe Count";
+            parameter.symbol = "probe_count";
+            parameter.description = "Number of probes answered";
+            break;
+        case kParamProbeLost:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 1000000.0f;
+            parameter.name = "Probe Lost";
+            parameter.symbol = "probe_lost";
+            parameter.description = "Number of probes not answered in time";
+            break;
+        case kParamProbeHistogram ... kParamProbeHistogramLast:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 1000000.0f;
+            parameter.name = "Probe Histogram " + String(index - kParamProbeHistogram + 1);
+            parameter.symbol = "probe_histogram" + String(index - kParamProbeHistogram + 1);
+            parameter.description = "Number of probes answered within this 5ms range, the last one includes all slower";
+            break;
+        case kParamStatsEmitted:
+        case kParamStatsDeferred:
+        case kParamStatsRejected:
+        case kParamStatsDropped:
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.max = 100000.0f;
+            parameter.unit = "events/s";
+            switch (index)
+            {
+            case kParamStatsEmitted:
+                parameter.name = "Events Emitted";
+                parameter.symbol = "stats_emitted";
+                parameter.description = "Events written to the host, including thru";
+                break;
+            case kParamStatsDeferred:
+                parameter.name = "Events Deferred";
+                parameter.symbol = "stats_deferred";
+                parameter.description = "Events held back for a later block, for lack of bandwidth or host room";
+                break;
+            case kParamStatsRejected:
+                parameter.name = "Events Rejected";
+                parameter.symbol = "stats_rejected";
+                parameter.description = "Events the host had no more room for";
+                break;
+            case kParamStatsDropped:
+                parameter.name = "Events Dropped";
+                parameter.symbol = "stats_dropped";
+                parameter.description = "Thru events thrown away as the host had no more room for them";
+                break;
+            }
+            break;
+        case kParamStatsPending:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 1024.0f;
+            parameter.name = "Pending Events";
+            parameter.symbol = "stats_pending";
+            parameter.description = "Highest number of actions and parameter changes waiting to be sent at the end of a block";
+            break;
+        case kParamStatsOverflows:
+            parameter.hints = kParameterIsOutput | kParameterIsInteger;
+            parameter.ranges.max = 1000000.0f;
+            parameter.name = "Commands Lost";
+            parameter.symbol = "stats_overflows";
+            parameter.description = "Commands dropped because the queue into the realtime side was full, since loading";
+            break;
+        case kParamStatsRunMin:
+        case kParamStatsRunAvg:
+        case kParamStatsRunMax:
+            parameter.hints = kParameterIsOutput;
+            parameter.ranges.max = 100000.0f;
+            parameter.unit = "us";
+            switch (index)
+            {
+            case kParamStatsRunMin:
+                parameter.name = "Run Time Min";
+                parameter.symbol = "stats_run_min";
+                parameter.description = "Shortest time spent processing a block";
+                break;
+            case kParamStatsRunAvg:
+                parameter.name = "Run Time Average";
+                parameter.symbol = "stats_run_avg";
+                parameter.description = "Average time spent processing a block";
+                break;
+            case kParamStatsRunMax:
+                parameter.name = "Run Time Max";
+                parameter.symbol = "stats_run_max";
+                parameter.description = "Longest time spent processing a block";
+                break;
+            }
             break;
         }
     }
 
+   /**
+      Initialize the state @a index.@n
+      This function will be called once, shortly after the plugin is created.
+    */
+    void initState(uint32_t index, State& state) override
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(index == 0,);
+
+        state.hints = kStateIsOnlyForDSP | kStateIsBase64Blob;
+        state.key = "full_state";
+        state.defaultValue = "";
+        state.label = "Full State";
+        state.description = "Bindings of all units, device locations and snapshots";
+    }
+
     // ----------------------------------------------------------------------------------------------------------------
     // Internal data
 
@@ -138,7 +922,16 @@ protected:
     float getParameterValue(uint32_t index) const override
     {
         DISTRHO_SAFE_ASSERT_RETURN(index < kParamCount, 0.0f);
-        return params[index];
+
+        if (index >= kParamBindingCount)
+            return extraParams[index - kParamBindingCount].load(std::memory_order_relaxed);
+
+        const uint32_t slot = getSlot(index, getSelectedUnit());
+
+        if (isHiResBinding(index))
+            return hiResParams[slot].load(std::memory_order_relaxed) / kHiResScale;
+
+        return params[slot].load(std::memory_order_relaxed);
     }
 
    /**
@@ -151,198 +944,2084 @@ protected:
     {
         DISTRHO_SAFE_ASSERT_RETURN(index < kParamCount,);
 
-        params[index] = std::clamp<int>(d_roundToIntPositive(value), 0, 127);
-        updatedParams[index] = true;
-    }
-
-   /**
-      Change an internal state @a key to @a value.
-    */
-    void setState(const char* key, const char* value) override
-    {
-        /**/ if (std::strcmp(key, "bank") == 0)
+        if (index >= kParamBindingCount)
         {
-            switch (value[0])
-            {
-            case '-':
-            case '+':
-                actions[kActionBank] = value[0];
-                break;
-            default:
-                actions[kActionBank] = std::atoi(value);
-                break;
-            }
-            updatedActions[kActionBank] = true;
+            extraParams[index - kParamBindingCount].store(value, std::memory_order_relaxed);
+            return;
         }
-        else if (std::strcmp(key, "preset") == 0)
+
+        // the full state has the bindings of every unit, the host restoring its own copy of them as well would apply
+        // them to whichever unit is selected at that moment, which depends on the order it restores things in
+        // (LV2 hosts apply ports within the first block, so this lasts until the next one starts, not just until activation)
+        if (restoringBindings.load(std::memory_order_acquire))
+            return;
+
+        const uint32_t unit = getSelectedUnit();
+        const uint32_t slot = getSlot(index, unit);
+        const int ivalue = std::clamp<int>(d_roundToIntPositive(value), 0, 127);
+        bool changed = params[slot].exchange(ivalue, std::memory_order_relaxed) != ivalue;
+
+        Command command = { kCommandParameter, static_cast<uint16_t>(index), ivalue, static_cast<uint8_t>(unit) };
+
+        if (isHiResBinding(index))
         {
-            switch (value[0])
+            const int hiResValue = std::clamp<int>(d_roundToIntPositive(value * kHiResScale), 0, HiResEncoder::kMaxValue);
+            changed = hiResParams[slot].exchange(hiResValue, std::memory_order_relaxed) != hiResValue;
+
+            if (getSetting(kParamHiResMode) > 0.5f)
             {
-            case '-':
-            case '+':
-                actions[kActionPreset] = value[0];
-                break;
-            default:
-                actions[kActionPreset] = std::atoi(value);
-                break;
+                command.type = kCommandHiResParameter;
+                command.value = hiResValue;
             }
-            updatedActions[kActionPreset] = true;
-        }
-        else if (std::strcmp(key, "scene") == 0)
-        {
-            actions[kActionScene] = value[0];
-            updatedActions[kActionScene] = true;
-        }
-        else if (std::strcmp(key, "mode") == 0)
-        {
-            actions[kActionMode] = value[0];
-            updatedActions[kActionMode] = true;
-        }
-        else if (std::strcmp(key, "tuner") == 0)
-        {
-            updatedActions[kActionTuner] = true;
         }
-    }
 
-    // ----------------------------------------------------------------------------------------------------------------
-    // Audio/MIDI Processing
+        // host confirming a change that came from the device, which already has this value
+        if (feedbackParams[slot].exchange(-1, std::memory_order_acq_rel) == ivalue)
+            return;
 
-   /**
-      Activate this plugin.
-    */
-    void activate() override
-    {
-        std::memset(updatedParams, 0, sizeof(updatedParams));
-        std::memset(updatedActions, 0, sizeof(updatedActions));
-        std::memset(actions, 0, sizeof(actions));
+        // host sending the same value again, such as constant automation, nothing to do
+        if (! changed)
+            return;
+
+        // on overflow the realtime side picks up the latest values directly from params
+        if (! commands.push(command))
+            paramsOverflowed.store(true, std::memory_order_release);
     }
 
    /**
-      Run/process function for plugins with MIDI input.
-      @note Some parameters might be null if there are no audio inputs/outputs or MIDI events.
+      Get the value of an internal state.@n
+      The host may call this function from any non-realtime context.
     */
-    void run(const float**, float**, uint32_t, const MidiEvent* midiEvents, uint32_t midiEventCount) override
+    String getState(const char* key) const override
     {
-        MidiEvent outEvent;
-        outEvent.frame = 0;
-
-        // actions
-        for (int i = 0; i < kActionCount; ++i)
-        {
-            if (! updatedActions[i])
-                continue;
+        if (kStateKeys.lookup(key) != kStateFullState)
+            return String();
 
-            outEvent.size = 3;
-            outEvent.data[0] = 0xB0;
+        uint8_t data[kFullStateMaxSize];
+        uint32_t size = 0;
 
-            switch (static_cast<Actions>(i))
+        const auto writeBindings = [&data, &size](const auto& getValue) {
+            for (uint32_t i = 0; i < kParamBindingCount; ++i)
             {
-            case kActionBank:
-                switch (actions[i])
-                {
-                default:
-                    outEvent.data[1] = 102;
-                    outEvent.data[2] = actions[i];
-                    break;
-                case '+':
-                    outEvent.data[1] = 103;
-                    outEvent.data[2] = 0;
-                    break;
-                case '-':
-                    outEvent.data[1] = 104;
-                    outEvent.data[2] = 0;
-                    break;
-                }
-                break;
-            case kActionPreset:
-                switch (actions[i])
-                {
-                default:
-                    outEvent.size = 2;
-                    outEvent.data[0] = 0xC0;
-                    outEvent.data[1] = actions[i];
-                    break;
-                case '+':
-                    outEvent.data[1] = 105;
-                    outEvent.data[2] = 0;
-                    break;
-                case '-':
-                    outEvent.data[1] = 106;
-                    outEvent.data[2] = 0;
-                    break;
-                }
-                break;
-            case kActionScene:
-                switch (actions[i])
-                {
-                case '0' ... '3':
-                    outEvent.data[1] = 107;
-                    outEvent.data[2] = std::clamp<uint8_t>(actions[i] - '0', 0, 3);
-                    break;
-                case '+':
-                    outEvent.data[1] = 108;
-                    outEvent.data[2] = 0;
-                    break;
-                case '-':
-                    outEvent.data[1] = 109;
-                    outEvent.data[2] = 0;
-                    break;
-                default:
-                    continue;
-                }
-                break;
-            case kActionMode:
-                outEvent.data[1] = 85;
-                outEvent.data[2] = std::clamp<uint8_t>(actions[i] - '1', 0, 2);
-                break;
-            case kActionTuner:
-                outEvent.data[1] = 86;
-                outEvent.data[2] = 0;
-                break;
-            default:
-                continue;
+                const int value = getValue(i);
+
+                if (isHiResBinding(i))
+                    data[size++] = value >> 8;
+
+                data[size++] = value & 0xff;
             }
+        };
 
-            if (! writeMidiEvent(outEvent))
-                break;
+        std::memcpy(data, kFullStateMagic, sizeof(kFullStateMagic));
+        size = sizeof(kFullStateMagic);
+        data[size++] = kFullStateVersion;
 
-            updatedActions[i] = false;
+        uint16_t stored = 0;
+        for (uint32_t i = 0; i < kSnapshotCount; ++i)
+        {
+            if (snapshotStored[i].load(std::memory_order_relaxed))
+                stored |= 1u << i;
         }
+        data[size++] = stored >> 8;
+        data[size++] = stored & 0xff;
 
-        // bindings
-        outEvent.size = 3;
-        outEvent.data[0] = 0xB0;
+        for (uint32_t unit = 0; unit < kMaxUnits; ++unit)
+        {
+            writeBindings([this, unit](const uint32_t index) {
+                const uint32_t slot = getSlot(index, unit);
+                return isHiResBinding(index) ? hiResParams[slot].load(std::memory_order_relaxed)
+                                             : params[slot].load(std::memory_order_relaxed);
+            });
+
+            for (uint32_t i = 0; i < kLocationCount; ++i)
+                data[size++] = static_cast<uint8_t>(locations[unit][i].load(std::memory_order_relaxed));
+        }
 
-        for (int i = 0; i < kParamCount; ++i)
+        for (uint32_t number = 0; number < kSnapshotCount; ++number)
         {
-            if (! updatedParams[i])
-                continue;
+            if ((stored >> number) & 1)
+            {
+                writeBindings([this, number](const uint32_t index) {
+                    return snapshots[number][index].load(std::memory_order_relaxed);
+                });
+            }
+        }
 
-            outEvent.data[2] = params[i];
+        return String::asBase64(data, size);
+    }
 
-            switch (static_cast<Parameters>(i))
+   /**
+      Change an internal state @a key to @a value.
+    */
+    void setState(const char* key, const char* value) override
+    {
+        switch (kStateKeys.lookup(key))
+        {
+        case kStateTimeline:
+            /**/ if (std::strcmp(value, "record") == 0)
             {
-            case kParamPot1 ... kParamPot6:
-                outEvent.data[1] = 20 + i;
-                break;
-            case kParamFoot1 ... kParamFoot3:
-                outEvent.data[1] = 17 + i - kParamFoot1;
-                break;
-            case kParamExpPedal:
-                outEvent.data[1] = 89;
-                break;
-            case kParamCCs ... kParamCount - 1:
-                outEvent.data[1] = kAllowedCCs[i - kParamCCs];
-                break;
-            default:
-                continue;
+                stopTimelineStream();
+                timelines.publish(new Timeline(kTimelineCapacity));
+                pushCommand({ kCommandTimeline, kTimelineRecord, 0, 0 });
             }
+            else if (std::strcmp(value, "play") == 0)
+            {
+                pushCommand({ kCommandTimeline, kTimelinePlay, 0, 0 });
+            }
+            else if (std::strcmp(value, "stop") == 0)
+            {
+                pushCommand({ kCommandTimeline, kTimelineStop, 0, 0 });
+            }
+            break;
 
-            if (! writeMidiEvent(outEvent))
-                break;
+        case kStateTimelineSave:
+            if (const Timeline* const current = timelines.getCurrent())
+                current->save(value, getSampleRate());
+            break;
 
-            updatedParams[i] = false;
-        }
+        case kStateTimelineLoad:
+            if (Timeline* const loaded = Timeline::load(value, getSampleRate(), kTimelineCapacity))
+            {
+                stopTimelineStream();
+                timelines.publish(loaded);
+                pushCommand({ kCommandTimeline, kTimelineLoaded, 0, 0 });
+            }
+            break;
+
+        case kStateTimelineStream:
+            streamTimeline(value);
+            break;
+
+        case kStateScript:
+            /**/ if (std::strcmp(value, "play") == 0)
+                pushCommand({ kCommandScript, kScriptPlay, 0, 0 });
+            else if (std::strcmp(value, "stop") == 0)
+                pushCommand({ kCommandScript, kScriptStop, 0, 0 });
+            break;
+
+        case kStateScriptLoad:
+            if (CommandScript* const loaded = CommandScript::load(value))
+            {
+                scripts.publish(loaded);
+                pushCommand({ kCommandScript, kScriptLoaded, 0, 0 });
+            }
+            break;
+
+        case kStateResync:
+            pushCommand({ kCommandResync, 0, 0, 0 });
+            break;
+
+        case kStateCommands:
+            pushCommands(value);
+            break;
+
+        case kStateSnapshotStore:
+            pushSnapshotCommand(kSnapshotStore, value);
+            break;
+
+        case kStateSnapshotRecall:
+            pushSnapshotCommand(kSnapshotRecall, value);
+            break;
+
+        case kStateSnapshotMorph:
+            pushSnapshotCommand(kSnapshotMorph, value);
+            break;
+
+        case kStateFullState:
+            restoreFullState(value);
+            break;
+
+        default:
+            // dropped actions are reported and counted, nothing else we can do for them
+            Command command;
+            if (parseAction(key, value, command))
+            {
+                command.channel = getSelectedUnit();
+                pushCommand(command);
+            }
+            break;
+        }
+    }
+
+   /**
+      Stream a saved timeline of any length, for offline rendering, without loading it all into memory.
+      A filename starts streaming into a window of kTimelineStreamWindow events, ready to play.
+      An empty value moves the window along by half once playback went past its first half,
+      the caller must do this at least once per block as nothing is read ahead of that.
+      Streamed timelines only play once and free-running, the window cannot seek back.
+    */
+    void streamTimeline(const char* const value)
+    {
+        static constexpr const uint32_t kHalfWindow = kTimelineStreamWindow / 2;
+        Timeline* window;
+
+        if (value[0] != '\0')
+        {
+            stopTimelineStream();
+
+            if (! timelineReader.open(value, getSampleRate()))
+                return;
+
+            window = new Timeline(kTimelineStreamWindow);
+        }
+        else
+        {
+            if (timelineWindow == nullptr || ! timelineWindow->isPartial())
+                return;
+            if (timelinePlayed.load(std::memory_order_acquire) < timelineWindow->getOffset() + kHalfWindow)
+                return;
+
+            // the previous window stays valid until the next publish
+            window = new Timeline(kTimelineStreamWindow, timelineWindow->getOffset() + kHalfWindow);
+
+            for (uint32_t i = kHalfWindow, count = timelineWindow->getCount(); i < count; ++i)
+            {
+                const Timeline::Event& event(timelineWindow->getEvent(i));
+                window->append(event.frame, event.command);
+            }
+        }
+
+        if (! timelineReader.read(*window))
+        {
+            d_stderr2("AnagramControlPlugin: failed to read timeline, streaming stopped");
+            delete window;
+            stopTimelineStream();
+            pushCommand({ kCommandTimeline, kTimelineStop, 0, 0 });
+            return;
+        }
+
+        window->setPartial(timelineReader.getRemaining() != 0);
+        timelineWindow = window;
+        timelines.publish(window);
+        pushCommand({ kCommandTimeline, static_cast<uint16_t>(value[0] != '\0' ? kTimelineLoaded : kTimelineStreamed), 0, 0 });
+    }
+
+    // any other timeline replaces the streamed one
+    void stopTimelineStream()
+    {
+        timelineReader.close();
+        timelineWindow = nullptr;
+    }
+
+   /**
+      Push a command from the control side, outside of realtime processing.
+      A full queue drops it, which is only counted by the queue (see kParamStatsOverflows),
+      printing each one would flood the console during action storms.
+    */
+    void pushCommand(const Command& command)
+    {
+        commands.push(command);
+    }
+
+   /**
+      Push a batch of commands written as "key=value;key=value", with the same keys as actions plus "ccN" for bindings.
+      Commands go to the selected unit, "channel=N" changes the unit for all commands after it.
+      Bindings follow the high resolution mode as in setParameterValue, CCs reserved by that mode are invalid.
+      The whole batch is rejected if any of its commands is invalid, otherwise it is dequeued as a whole and sent in order.
+      Batches are ordered but not atomic on the device: it sees the whole sequence in order, but applies each message
+      as it arrives, and sending is paced like any other action, so a batch may be spread over several blocks.
+    */
+    void pushCommands(const char* const value)
+    {
+        Command batch[kMaxBatchSize + 1];
+        uint32_t count = 0;
+        uint8_t channel = getSelectedUnit();
+
+        const uint32_t mode = std::min<uint32_t>(d_roundToUnsignedInt(getSetting(kParamHiResMode)), HiResEncoder::kModeNRPN);
+
+        for (const char* item = value; *item != '\0';)
+        {
+            const char* const end = item + std::strcspn(item, ";");
+            const char* const separator = item + std::strcspn(item, "=;");
+            const size_t keyLength = separator - item;
+            const size_t valueLength = separator != end ? end - separator - 1 : 0;
+
+            char itemKey[16], itemValue[16];
+
+            if (keyLength >= sizeof(itemKey) || valueLength >= sizeof(itemValue) || count == kMaxBatchSize)
+            {
+                d_stderr2("AnagramControlPlugin: batch item too long or too many items, batch ignored");
+                return;
+            }
+
+            std::memcpy(itemKey, item, keyLength);
+            itemKey[keyLength] = '\0';
+            std::memcpy(itemValue, separator + 1, valueLength);
+            itemValue[valueLength] = '\0';
+
+            item = *end != '\0' ? end + 1 : end;
+
+            if (keyLength == 0)
+                continue;
+
+            Command& command(batch[count + 1]);
+
+            if (std::strcmp(itemKey, "channel") == 0)
+            {
+                const int newChannel = std::atoi(itemValue);
+
+                if (newChannel >= 1 && newChannel <= static_cast<int>(kMaxUnits))
+                {
+                    channel = newChannel - 1;
+                    continue;
+                }
+            }
+            else if (parseBinding(itemKey, itemValue, command))
+            {
+                // the realtime side would silently skip it, better to tell the sender
+                if (isHiResReservedCC(mode, kParamToCC[command.index]))
+                {
+                    d_stderr2("AnagramControlPlugin: batch item '%s' is reserved by the high resolution mode, batch ignored",
+                              itemKey);
+                    return;
+                }
+
+                if (mode != HiResEncoder::kModeOff && isHiResBinding(command.index))
+                {
+                    command.type = kCommandHiResParameter;
+                    command.value = std::clamp<int>(d_roundToIntPositive(command.value * kHiResScale),
+                                                    0, HiResEncoder::kMaxValue);
+                }
+
+                command.channel = channel;
+                ++count;
+                continue;
+            }
+            else if (parseAction(itemKey, itemValue, command))
+            {
+                command.channel = channel;
+                ++count;
+                continue;
+            }
+
+            d_stderr2("AnagramControlPlugin: invalid batch item '%s=%s', batch ignored", itemKey, itemValue);
+            return;
+        }
+
+        if (count == 0)
+            return;
+
+        // same as setParameterValue, so that bindings report and resync the new values
+        for (uint32_t i = 1; i <= count; ++i)
+        {
+            const uint32_t slot = getSlot(batch[i].index, batch[i].channel);
+
+            switch (batch[i].type)
+            {
+            case kCommandParameter:
+                params[slot].store(batch[i].value, std::memory_order_relaxed);
+                if (isHiResBinding(batch[i].index))
+                    hiResParams[slot].store(batch[i].value * kHiResScale, std::memory_order_relaxed);
+                break;
+            case kCommandHiResParameter:
+                params[slot].store(batch[i].value >> 7, std::memory_order_relaxed);
+                hiResParams[slot].store(batch[i].value, std::memory_order_relaxed);
+                break;
+            }
+        }
+
+        batch[0] = { kCommandBatch, 0, static_cast<int32_t>(count), 0 };
+
+        // bindings are picked up again from params, but the actions are lost
+        if (! commands.pushBatch(batch, count + 1))
+        {
+            d_stderr2("AnagramControlPlugin: command queue full, batch of %u commands dropped", count);
+            paramsOverflowed.store(true, std::memory_order_release);
+        }
+    }
+
+   /**
+      Restore a blob from getState(), it is either taken as a whole or ignored.
+      The realtime side then sends everything again, same as a resync.
+      Host binding parameters are ignored until the next block, the blob already has the values of every unit.
+    */
+    void restoreFullState(const char* const value)
+    {
+        // hosts set the default empty value on new instances
+        if (value[0] == '\0')
+            return;
+
+        const std::vector<uint8_t> data(d_getChunkFromBase64String(value));
+
+        if (data.size() < kFullStateHeaderSize
+            || std::memcmp(data.data(), kFullStateMagic, sizeof(kFullStateMagic)) != 0
+            || data[sizeof(kFullStateMagic)] != kFullStateVersion)
+        {
+            d_stderr2("AnagramControlPlugin: invalid full state, ignored");
+            return;
+        }
+
+        uint32_t pos = sizeof(kFullStateMagic) + 1;
+        const uint16_t stored = data[pos] << 8 | data[pos + 1];
+        pos += 2;
+
+        const uint32_t expectedSize = kFullStateHeaderSize
+                                    + kMaxUnits * (getBindingsSize() + kLocationCount)
+                                    + __builtin_popcount(stored) * getBindingsSize();
+
+        if (data.size() != expectedSize)
+        {
+            d_stderr2("AnagramControlPlugin: full state has the wrong size, ignored");
+            return;
+        }
+
+        // out of range values are clamped, so nothing from a blob ends up on the wire as-is
+        const auto readBinding = [&data, &pos](const uint32_t index) -> int {
+            if (! isHiResBinding(index))
+                return std::min<int>(data[pos++], 127);
+
+            const int value = data[pos] << 8 | data[pos + 1];
+            pos += 2;
+            return std::min<int>(value, HiResEncoder::kMaxValue);
+        };
+
+        for (uint32_t unit = 0; unit < kMaxUnits; ++unit)
+        {
+            for (uint32_t i = 0; i < kParamBindingCount; ++i)
+            {
+                const uint32_t slot = getSlot(i, unit);
+                const int binding = readBinding(i);
+
+                if (isHiResBinding(i))
+                {
+                    hiResParams[slot].store(binding, std::memory_order_relaxed);
+                    params[slot].store(d_roundToIntPositive(binding / kHiResScale), std::memory_order_relaxed);
+                }
+                else
+                {
+                    params[slot].store(binding, std::memory_order_relaxed);
+                }
+            }
+
+            for (uint32_t i = 0; i < kLocationCount; ++i)
+            {
+                const int8_t location = static_cast<int8_t>(data[pos++]);
+                locations[unit][i].store(location, std::memory_order_relaxed);
+            }
+        }
+
+        for (uint32_t number = 0; number < kSnapshotCount; ++number)
+        {
+            const bool isStored = (stored >> number) & 1;
+
+            if (isStored)
+            {
+                for (uint32_t i = 0; i < kParamBindingCount; ++i)
+                    snapshots[number][i].store(readBinding(i), std::memory_order_relaxed);
+            }
+
+            snapshotStored[number].store(isStored, std::memory_order_relaxed);
+        }
+
+        restoringBindings.store(true, std::memory_order_release);
+        stateRestored.store(true, std::memory_order_release);
+    }
+
+   /**
+      Push a snapshot command for the selected unit, @a value is a snapshot number (1-16), or two of them for a morph.
+    */
+    void pushSnapshotCommand(const uint32_t op, const char* const value)
+    {
+        const auto isValid = [](const int number) { return number >= 1 && number <= static_cast<int>(kSnapshotCount); };
+
+        int first = 0, second = 0;
+        const int count = std::sscanf(value, "%d %d", &first, &second);
+
+        if (count != (op == kSnapshotMorph ? 2 : 1) || ! isValid(first) || (op == kSnapshotMorph && ! isValid(second)))
+        {
+            d_stderr2("AnagramControlPlugin: invalid snapshot '%s'", value);
+            return;
+        }
+
+        const int32_t numbers = (first - 1) | (op == kSnapshotMorph ? (second - 1) << 8 : 0);
+        pushCommand({ kCommandSnapshot, static_cast<uint16_t>(op), numbers, getSelectedUnit() });
+    }
+
+   /**
+      Parse a binding given as "ccN" and a value, only bound CCs are valid.
+    */
+    static bool parseBinding(const char* const key, const char* const value, Command& command) noexcept
+    {
+        if (key[0] != 'c' || key[1] != 'c' || key[2] < '0' || key[2] > '9')
+            return false;
+
+        char* end;
+        const long cc = std::strtol(key + 2, &end, 10);
+
+        if (*end != '\0' || cc > 127 || kCCToParam[cc] == kCCUnbound)
+            return false;
+
+        command = { kCommandParameter, kCCToParam[cc], std::clamp(std::atoi(value), 0, 127), 0 };
+        return true;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // Audio/MIDI Processing
+
+   /**
+      Activate this plugin.
+    */
+    void activate() override
+    {
+        commands.clear();
+        paramsOverflowed.store(false, std::memory_order_relaxed);
+        updatedParams.clear();
+        for (OutputRoute& route : routes)
+        {
+            route.pendingActions.clear();
+            route.scheduler.reset();
+            route.encoder.reset();
+        }
+        for (HiResEncoder& hiResEncoder : hiResEncoders)
+            hiResEncoder.reset();
+        for (ParameterRamp& ramp : ramps)
+            ramp.clear();
+        activeRamps.clear();
+        morphBindings.clear();
+        stateRestored.store(false, std::memory_order_relaxed);
+        resendPending = getSetting(kParamResendOnActivate) > 0.5f;
+        frameCounter = 0;
+        framesSinceResync = 0;
+        maxActionLatency = 0;
+        std::fill(std::begin(lastSentParams), std::end(lastSentParams), -1);
+        setOutputParameter(kParamActionLatency, 0.0f);
+        stressGenerator.reset();
+        stressBindings.clear();
+        resetStressCounters();
+        resetProbe(kProbeOff);
+        stats.reset();
+    }
+
+   /**
+      Run/process function for plugins with MIDI input.
+      @note Some parameters might be null if there are no audio inputs/outputs or MIDI events.
+    */
+    void run(const float**, float**, const uint32_t frames, const MidiEvent* midiEvents, uint32_t midiEventCount) override
+    {
+        const RealtimeStats::Clock::time_point runStart = RealtimeStats::Clock::now();
+
+        // host parameters of this block were already applied, anything from now on is a change of its own
+        restoringBindings.store(false, std::memory_order_release);
+
+        // timeline clock, following host transport if possible
+        const TimePosition& timePos(getTimePosition());
+        const bool followTransport = getSetting(kParamTimelineSync) > 0.5f;
+        const auto getTimelineClock = [&]() -> uint64_t {
+            return followTransport && timePos.playing ? timePos.frame : timelineFrame;
+        };
+        uint64_t timelineStart = getTimelineClock();
+
+        unitCount = getUnitCount();
+        selectedUnit = getSelectedUnit();
+
+        // new values for high resolution bindings start a ramp into them
+        const uint32_t rampFrames = d_roundToUnsignedInt(getSetting(kParamSmoothing) * getSampleRate() / 1000.0);
+
+        // take everything queued from the control side, actions keep their order and count
+        bool resync = false;
+
+        uint32_t batchRemaining = 0;
+
+        for (;;)
+        {
+            const Command* const cmd = commands.peek();
+
+            if (cmd == nullptr)
+                break;
+
+            CommandFifo<PendingAction, 256>& pendingActions(routes[getRouteIndex(cmd->channel)].pendingActions);
+
+            if (pendingActions.isFull())
+                break;
+
+            // batches are taken as a whole or left for the next block, so nothing else gets in between them
+            if (cmd->type == kCommandBatch)
+            {
+                const uint32_t count = cmd->value;
+
+                if (! commands.isReadable(count + 1) || ! hasRoomForActions(count))
+                    break;
+
+                batchRemaining = count + 1;
+            }
+
+            const bool inBatch = batchRemaining != 0;
+            const uint32_t slot = getSlot(cmd->index, cmd->channel);
+
+            if (inBatch)
+                --batchRemaining;
+
+            switch (cmd->type)
+            {
+            case kCommandAction:
+                pendingActions.push({ *cmd, frameCounter });
+                break;
+            case kCommandParameter:
+                stopMorph(cmd->index, cmd->channel);
+                // bindings within a batch are sent along with its actions, keeping their order
+                if (inBatch)
+                {
+                    pendingActions.push({ *cmd, frameCounter });
+                    pendingParams[slot] = cmd->value;
+                    if (isHiResBinding(cmd->index))
+                        ramps[slot].jump(cmd->value * kHiResScale);
+                    break;
+                }
+                pendingParams[slot] = cmd->value;
+                if (isHiResBinding(cmd->index))
+                    setRampTarget(slot, cmd->value * kHiResScale, rampFrames);
+                updatedParams.set(slot);
+                break;
+            case kCommandHiResParameter:
+                if (inBatch)
+                {
+                    stopMorph(cmd->index, cmd->channel);
+                    pendingActions.push({ *cmd, frameCounter });
+                    pendingParams[slot] = cmd->value >> 7;
+                    ramps[slot].jump(cmd->value);
+                    break;
+                }
+                pendingParams[slot] = cmd->value >> 7;
+                setRampTarget(slot, cmd->value, rampFrames);
+                updatedParams.set(slot);
+                break;
+            case kCommandTimeline:
+                handleTimelineCommand(cmd->index);
+                timelineStart = getTimelineClock();
+                break;
+            case kCommandScript:
+                handleScriptCommand(cmd->index);
+                break;
+            case kCommandResync:
+                resync = true;
+                break;
+            case kCommandBatch:
+                break;
+            case kCommandSnapshot:
+                handleSnapshotCommand(cmd->index, cmd->value, cmd->channel, rampFrames);
+                break;
+            }
+
+            // only commands that result in MIDI are recorded, all at the start of the block they are taken in
+            if (timelineMode == kTimelineRecord && isRecordable(*cmd))
+            {
+                if (! timeline->append(timelineStart, *cmd))
+                    timelineMode = kTimelineStop;
+            }
+
+            commands.skip();
+        }
+
+        // a restored session, or the first block after activation if so requested, brings back everything we know
+        if (stateRestored.exchange(false, std::memory_order_acquire) || resendPending)
+        {
+            resendPending = false;
+            resync = true;
+        }
+
+        const float resyncInterval = getSetting(kParamResyncInterval);
+
+        if (resyncInterval > 0.0f && framesSinceResync >= resyncInterval * getSampleRate())
+            resync = true;
+
+        // the device state is no longer trusted, so everything is sent again, paced like any other change
+        // locations go first, a rebooted device is back on its default bank and preset
+        if (resync)
+        {
+            queueLocations();
+            std::fill(std::begin(lastSentParams), std::end(lastSentParams), -1);
+            for (HiResEncoder& hiResEncoder : hiResEncoders)
+                hiResEncoder.reset();
+            framesSinceResync = 0;
+        }
+
+        // only units in use are sent again, others keep whatever they have
+        if (paramsOverflowed.exchange(false, std::memory_order_acquire) || resync)
+        {
+            for (uint32_t i = 0; i < kParamBindingCount; ++i)
+            {
+                for (uint32_t unit = 0; unit < unitCount; ++unit)
+                {
+                    const uint32_t slot = getSlot(i, unit);
+
+                    pendingParams[slot] = params[slot].load(std::memory_order_relaxed);
+
+                    if (isHiResBinding(i))
+                        setRampTarget(slot, hiResParams[slot].load(std::memory_order_relaxed), rampFrames);
+
+                    updatedParams.set(slot);
+                }
+            }
+        }
+
+        // unlike running status, what the device last received stays valid across blocks
+        // generic bindings freed by a mode change are sent again, as their CCs carried other values meanwhile
+        const uint32_t newHiResMode = std::min<uint32_t>(d_roundToUnsignedInt(getSetting(kParamHiResMode)),
+                                                         HiResEncoder::kModeNRPN);
+
+        if (newHiResMode != hiResMode)
+        {
+            for (uint32_t i = kParamCCs; i < kParamBindingCount; ++i)
+            {
+                if (! isHiResReservedCC(hiResMode, kParamToCC[i]) && ! isHiResReservedCC(newHiResMode, kParamToCC[i]))
+                    continue;
+
+                for (uint32_t unit = 0; unit < kMaxUnits; ++unit)
+                {
+                    const uint32_t slot = getSlot(i, unit);
+
+                    lastSentParams[slot] = -1;
+
+                    if (unit < unitCount)
+                        updatedParams.set(slot);
+                }
+            }
+
+            hiResMode = newHiResMode;
+        }
+
+        // bindings being morphed move along with it, unless changed by something else
+        if (! morphBindings.isEmpty())
+            advanceMorph(frames);
+
+        // midi thru, merged by frame with what we generate below
+        thruIndex = 0;
+        thruEvents = midiEvents;
+        thruEventCount = getSetting(kParamThru) > 0.5f ? midiEventCount : 0;
+
+        if (thruEventCount != 0)
+        {
+            thruFilter.channel = d_roundToUnsignedInt(getSetting(kParamThruChannel));
+            thruFilter.firstCC = d_roundToUnsignedInt(getSetting(kParamThruFirstCC));
+            thruFilter.lastCC = d_roundToUnsignedInt(getSetting(kParamThruLastCC));
+            thruFilter.override = getSetting(kParamThruOverride) > 0.5f;
+            thruConflicts = updatedParams;
+        }
+
+        // probes restart from scratch whenever the mode changes
+        const uint32_t newProbeMode = std::min<uint32_t>(d_roundToUnsignedInt(getSetting(kParamProbeMode)), kProbeCC);
+
+        if (newProbeMode != probeMode)
+            resetProbe(newProbeMode);
+
+        // device feedback, except for controllers where our own values override the incoming ones
+        for (uint32_t i = 0; i < midiEventCount; ++i)
+        {
+            const MidiEvent& event(midiEvents[i]);
+
+            if (event.size > MidiEvent::kDataSize)
+                continue;
+
+            if (probeWaiting)
+                checkProbeAnswer(event);
+
+            trackLocation(event.data, event.size);
+
+            const uint8_t channel = event.data[0] & 0x0F;
+
+            switch (event.data[0] & 0xF0)
+            {
+            case 0xB0:
+                if (event.size == 3 && ! isThruConflict(event.data[0], event.data[1] & 0x7f))
+                    handleFeedbackCC(channel, event.data[1] & 0x7f, event.data[2] & 0x7f);
+                break;
+            case 0xC0:
+                if (event.size == 2 && channel == selectedUnit)
+                    setOutputParameter(kParamDevicePreset, event.data[1] & 0x7f);
+                break;
+            }
+        }
+
+        // spread events over the block and the link bandwidth, anything that does not fit is sent later
+        const double sampleRate = getSampleRate();
+        const float spacing = getSetting(kParamEventSpacing);
+        const float linkRate = getSetting(kParamLinkRate);
+        const uint32_t newRouting = std::min<uint32_t>(d_roundToUnsignedInt(getSetting(kParamOutputRouting)),
+                                                       kRoutingPerUnit);
+
+        // links of the previous routing have nothing to do with the new ones
+        if (newRouting != routing)
+        {
+            for (OutputRoute& route : routes)
+                route.scheduler.reset();
+
+            routing = newRouting;
+        }
+
+        // the host may merge or reorder streams between blocks, so running status never carries over
+        useRunningStatus = getSetting(kParamRunningStatus) > 0.5f;
+
+        for (uint32_t r = 0, count = getRouteCount(); r < count; ++r)
+        {
+            OutputRoute& route(routes[r]);
+            route.scheduler.setSpacing(d_roundToUnsignedInt(spacing * sampleRate / 1000.0));
+            route.scheduler.setLinkRate(d_roundToUnsignedInt(linkRate), sampleRate);
+            route.scheduler.beginBlock(frames);
+            route.encoder.reset();
+        }
+
+        blockedRoutes = 0;
+        lastFrame = 0;
+
+        MidiEvent outEvent;
+
+        // actions, always first, a route with actions left blocks everything else from being written into it
+        for (OutputRoute& route : routes)
+        {
+            CommandFifo<PendingAction, 256>& pendingActions(route.pendingActions);
+
+            while (! pendingActions.isEmpty())
+            {
+                const PendingAction& action(pendingActions.front());
+
+                if (action.command.type == kCommandParameter || action.command.type == kCommandHiResParameter)
+                {
+                    if (! writeCommand(action.command, 0, outEvent))
+                        break;
+                }
+                else if (encodeAction(action.command, outEvent))
+                {
+                    if (! writeScheduledEvent(outEvent))
+                        break;
+
+                    const uint32_t latency = frameCounter + outEvent.frame - action.frame;
+
+                    if (latency > maxActionLatency)
+                    {
+                        maxActionLatency = latency;
+                        setOutputParameter(kParamActionLatency, latency * 1000.0 / sampleRate);
+                    }
+                }
+
+                pendingActions.pop();
+            }
+
+            if (! pendingActions.isEmpty())
+                blockRoute(pendingActions.front().command.channel);
+        }
+
+        // latency probe, as soon as possible so that the measurement is not affected by lower priority events
+        if (probeMode != kProbeOff)
+            sendProbe(frames, outEvent);
+
+        // timeline playback, same priority as actions
+        if (timelineMode == kTimelinePlay)
+        {
+            if (! followTransport || timePos.playing)
+                playTimeline(timelineStart, frames, rampFrames, outEvent);
+        }
+
+        // script playback, same priority as the timeline
+        if (scriptPlaying)
+            playScript(frames, outEvent);
+
+        // stress generator, when enabled
+        stressGenerator.configure(d_roundToUnsignedInt(getSetting(kParamStressMode)),
+                                  d_roundToUnsignedInt(getSetting(kParamStressSeed)));
+
+        if (stressGenerator.isEnabled())
+        {
+            generateStress(frames, outEvent);
+        }
+        else
+        {
+            if (stressWindow != 0)
+                resetStressCounters();
+
+            restoreStressBindings();
+        }
+
+        // bindings, by priority and only visiting the ones that changed, each priority covering all units at once
+        // values that change while waiting are coalesced, only the latest one is sent
+        // a unit whose route runs out of room keeps the rest of its bindings for later, other routes carry on
+        {
+            const auto writeBinding = [this, &outEvent](const uint32_t slot) -> bool {
+                const uint8_t cc = kParamToCC[slot / kMaxUnits];
+
+                // the device already has this value, or the CC is taken until the high resolution mode changes
+                if (pendingParams[slot] == lastSentParams[slot] || isHiResReservedCC(hiResMode, cc))
+                {
+                    updatedParams.reset(slot);
+                    return true;
+                }
+
+                outEvent.size = 3;
+                outEvent.data[0] = 0xB0 | (slot % kMaxUnits);
+                outEvent.data[1] = cc;
+                outEvent.data[2] = pendingParams[slot];
+
+                if (! writeScheduledEvent(outEvent))
+                {
+                    blockRoute(slot % kMaxUnits);
+                    return ! areAllRoutesBlocked();
+                }
+
+                lastSentParams[slot] = pendingParams[slot];
+                updatedParams.reset(slot);
+                return true;
+            };
+
+            for (const auto& priority : kBindingPriorities)
+            {
+                const uint32_t first = getSlot(priority.first, 0);
+                const uint32_t last = getSlot(priority.last, 0);
+                const bool written = isHiResBinding(priority.first)
+                                   ? writeRamps(first, last, frames, outEvent)
+                                   : updatedParams.visit(first, last, writeBinding);
+
+                if (! written)
+                    break;
+            }
+        }
+
+        // ramps still moving are looked at again on the next block, even if they reach their target right now
+        activeRamps.visit(0, kHiResSlotCount, [this, frames](const uint32_t slot) -> bool {
+            if (ramps[slot].isActive())
+            {
+                ramps[slot].advance(frames);
+                updatedParams.set(slot);
+            }
+            else
+            {
+                activeRamps.reset(slot);
+            }
+            return true;
+        });
+
+        // whatever thru events are left after the last generated one
+        writeThruEvents(frames);
+
+        for (uint32_t r = 0, count = getRouteCount(); r < count; ++r)
+            routes[r].scheduler.endBlock();
+
+        frameCounter += frames;
+        framesSinceResync += frames;
+
+        if (timelineMode != kTimelineStop && (! followTransport || timePos.playing))
+            timelineFrame = timelineStart + frames;
+
+        setOutputParameter(kParamTimelineState, timelineMode);
+        setOutputParameter(kParamTimelineEvents, timeline != nullptr ? timeline->getCount() : 0);
+        setOutputParameter(kParamTimelinePosition, timelineIndex);
+        timelinePlayed.store(timeline != nullptr ? timeline->getOffset() + timelineIndex : 0, std::memory_order_release);
+        setOutputParameter(kParamScriptState, scriptPlaying ? kScriptPlay : kScriptStop);
+        setOutputParameter(kParamScriptEvents, script != nullptr ? script->getCount() : 0);
+        setOutputParameter(kParamScriptPosition, scriptIndex);
+
+        RealtimeStats::Snapshot snapshot;
+        uint32_t pendingCount = updatedParams.getCount();
+        for (const OutputRoute& route : routes)
+            pendingCount += route.pendingActions.getCount();
+
+        if (stats.endRun(runStart, frames, pendingCount, sampleRate, snapshot))
+        {
+            setOutputParameter(kParamStatsEmitted, snapshot.emitted);
+            setOutputParameter(kParamStatsDeferred, snapshot.deferred);
+            setOutputParameter(kParamStatsRejected, snapshot.rejected);
+            setOutputParameter(kParamStatsDropped, snapshot.dropped);
+            setOutputParameter(kParamStatsPending, snapshot.maxPending);
+            setOutputParameter(kParamStatsOverflows, commands.getOverflowCount());
+            setOutputParameter(kParamStatsRunMin, snapshot.minRun);
+            setOutputParameter(kParamStatsRunAvg, snapshot.avgRun);
+            setOutputParameter(kParamStatsRunMax, snapshot.maxRun);
+        }
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+
+    void handleTimelineCommand(const uint32_t op)
+    {
+        switch (op)
+        {
+        case kTimelineStop:
+            timelineMode = kTimelineStop;
+            break;
+        case kTimelineRecord:
+        case kTimelineLoaded:
+            timeline = timelines.take();
+            timelineMode = op == kTimelineRecord && timeline != nullptr ? kTimelineRecord : kTimelineStop;
+            timelineIndex = 0;
+            timelineFrame = 0;
+            break;
+        case kTimelinePlay:
+            if (timeline == nullptr)
+                break;
+            timelineMode = kTimelinePlay;
+            timelineIndex = 0;
+            timelineFrame = 0;
+            break;
+        case kTimelineStreamed:
+            // carry on from the same event, which the new window has at another index
+            if (timeline != nullptr)
+            {
+                const uint64_t position = timeline->getOffset() + timelineIndex;
+                timeline = timelines.take();
+                timelineIndex = position > timeline->getOffset() ? position - timeline->getOffset() : 0;
+            }
+            break;
+        }
+    }
+
+   /**
+      Write all timeline events within this block, at their recorded frame unless held back by the scheduler.
+      Snapshot recalls and morphs are applied from the snapshots stored at the time of playback,
+      the bindings they change are then sent like any other change.
+      The position is looked up again whenever the host transport jumps.
+    */
+    void playTimeline(const uint64_t start, const uint32_t frames, const uint32_t rampFrames, MidiEvent& outEvent)
+    {
+        const uint32_t count = timeline->getCount();
+
+        if (start != timelineFrame)
+            timelineIndex = timeline->findFrame(start);
+
+        for (; timelineIndex < count; ++timelineIndex)
+        {
+            const Timeline::Event& event(timeline->getEvent(timelineIndex));
+
+            if (event.frame >= start + frames)
+                break;
+
+            if (event.command.type == kCommandSnapshot)
+            {
+                handleSnapshotCommand(event.command.index, event.command.value, event.command.channel, rampFrames);
+                continue;
+            }
+
+            if (! writeCommand(event.command, event.frame > start ? event.frame - start : 0, outEvent))
+                return;
+        }
+
+        // free-running playback stops at the end, synced one waits for the transport to loop back
+        // the end of a streamed window is not the end of the timeline, the next window is on its way
+        if (timelineIndex == count && ! timeline->isPartial() && ! (getSetting(kParamTimelineSync) > 0.5f))
+            timelineMode = kTimelineStop;
+    }
+
+    // commands that change what the device receives, snapshot stores only change what a later recall does
+    static bool isRecordable(const Command& command) noexcept
+    {
+        switch (command.type)
+        {
+        case kCommandAction:
+        case kCommandParameter:
+        case kCommandHiResParameter:
+            return true;
+        case kCommandSnapshot:
+            return command.index != kSnapshotStore;
+        default:
+            return false;
+        }
+    }
+
+    void handleScriptCommand(const uint32_t op)
+    {
+        switch (op)
+        {
+        case kScriptStop:
+            scriptPlaying = false;
+            break;
+        case kScriptLoaded:
+            script = scripts.take();
+            scriptPlaying = false;
+            scriptIndex = 0;
+            break;
+        case kScriptPlay:
+            scriptPlaying = script != nullptr;
+            scriptDelayed = false;
+            scriptIndex = 0;
+            scriptDue = 0.0;
+            break;
+        }
+    }
+
+    void handleSnapshotCommand(const uint32_t op, const int32_t numbers, const uint8_t channel, const uint32_t rampFrames)
+    {
+        const uint32_t first = numbers & 0xff;
+        const uint32_t second = (numbers >> 8) & 0xff;
+
+        DISTRHO_SAFE_ASSERT_RETURN(first < kSnapshotCount && second < kSnapshotCount && channel < kMaxUnits,);
+
+        switch (op)
+        {
+        case kSnapshotStore:
+            storeSnapshot(first, channel);
+            break;
+        case kSnapshotRecall:
+            recallSnapshot(first, channel, rampFrames);
+            break;
+        case kSnapshotMorph:
+            startMorph(first, second, channel);
+            break;
+        }
+    }
+
+   /**
+      Store all bindings of the unit on @a channel into a snapshot, as they are on the control side.
+    */
+    void storeSnapshot(const uint32_t number, const uint8_t channel)
+    {
+        for (uint32_t i = 0; i < kParamBindingCount; ++i)
+        {
+            const uint32_t slot = getSlot(i, channel);
+            const int value = isHiResBinding(i) ? hiResParams[slot].load(std::memory_order_relaxed)
+                                                : params[slot].load(std::memory_order_relaxed);
+
+            snapshots[number][i].store(value, std::memory_order_relaxed);
+        }
+
+        snapshotStored[number].store(true, std::memory_order_relaxed);
+    }
+
+   /**
+      Recall a snapshot into the unit on @a channel, only bindings with a different value are sent.
+      These are paced like any other change, so even a full recall is a single burst taking a bounded time.
+    */
+    void recallSnapshot(const uint32_t number, const uint8_t channel, const uint32_t rampFrames)
+    {
+        if (! snapshotStored[number].load(std::memory_order_relaxed))
+            return;
+
+        if (channel == morphUnit)
+            finishMorph();
+
+        for (uint32_t i = 0; i < kParamBindingCount; ++i)
+        {
+            const int value = snapshots[number][i].load(std::memory_order_relaxed);
+
+            if (! setBindingValue(i, channel, value))
+                continue;
+
+            const uint32_t slot = getSlot(i, channel);
+
+            if (isHiResBinding(i))
+            {
+                pendingParams[slot] = value >> 7;
+                setRampTarget(slot, value, rampFrames);
+            }
+            else
+            {
+                pendingParams[slot] = value;
+            }
+
+            updatedParams.set(slot);
+        }
+    }
+
+   /**
+      Morph the unit on @a channel from snapshot @a from into @a to, over the morph time.
+      The unit jumps into the first snapshot, then high resolution bindings ramp into the second one
+      and all others are moved along by advanceMorph(), so only changes of their quantized value are sent.
+      Bindings take their final values on the control side right away.
+    */
+    void startMorph(const uint32_t from, const uint32_t to, const uint8_t channel)
+    {
+        if (! snapshotStored[from].load(std::memory_order_relaxed) || ! snapshotStored[to].load(std::memory_order_relaxed))
+            return;
+
+        finishMorph();
+        morphFrom = from;
+        morphTo = to;
+        morphUnit = channel;
+        morphFrames = std::max(1u, d_roundToUnsignedInt(getSetting(kParamMorphTime) * getSampleRate() / 1000.0));
+        morphElapsed = 0;
+
+        for (uint32_t i = 0; i < kParamBindingCount; ++i)
+        {
+            const int fromValue = snapshots[from][i].load(std::memory_order_relaxed);
+            const int toValue = snapshots[to][i].load(std::memory_order_relaxed);
+            const uint32_t slot = getSlot(i, channel);
+
+            setBindingValue(i, channel, toValue);
+
+            if (isHiResBinding(i))
+            {
+                ramps[slot].jump(fromValue);
+                setRampTarget(slot, toValue, morphFrames);
+                pendingParams[slot] = toValue >> 7;
+            }
+            else
+            {
+                pendingParams[slot] = fromValue;
+
+                if (fromValue != toValue)
+                    morphBindings.set(i);
+            }
+
+            // only sent if different from what the device has
+            updatedParams.set(slot);
+        }
+    }
+
+   /**
+      Move morphing bindings into where they should be at the start of this block.
+      Only bindings whose quantized value changed are marked for sending.
+    */
+    void advanceMorph(const uint32_t frames)
+    {
+        const double position = std::min(1.0, static_cast<double>(morphElapsed) / morphFrames);
+
+        morphBindings.visit(0, kParamBindingCount, [this, position](const uint32_t index) {
+            const int fromValue = snapshots[morphFrom][index].load(std::memory_order_relaxed);
+            const int toValue = snapshots[morphTo][index].load(std::memory_order_relaxed);
+            const int value = d_roundToIntPositive(fromValue + (toValue - fromValue) * position);
+            const uint32_t slot = getSlot(index, morphUnit);
+
+            if (pendingParams[slot] != value)
+            {
+                pendingParams[slot] = value;
+                updatedParams.set(slot);
+            }
+
+            return true;
+        });
+
+        if (position >= 1.0)
+            morphBindings.clear();
+
+        morphElapsed += frames;
+    }
+
+    // jump morphing bindings into their final values, the control side already has them
+    void finishMorph()
+    {
+        if (morphBindings.isEmpty())
+            return;
+
+        morphElapsed = morphFrames;
+        advanceMorph(0);
+    }
+
+    // something else changed a binding, which then stops following the morph
+    void stopMorph(const uint32_t index, const uint8_t channel) noexcept
+    {
+        if (channel == morphUnit && index < kParamBindingCount)
+            morphBindings.reset(index);
+    }
+
+   /**
+      Make @a value the current one of a binding on the control side, as from a snapshot or script.
+      Returns false if it already was, in which case there is nothing to send.
+    */
+    bool setBindingValue(const uint32_t index, const uint8_t channel, const int value)
+    {
+        const uint32_t slot = getSlot(index, channel);
+
+        if (isHiResBinding(index))
+        {
+            if (hiResParams[slot].load(std::memory_order_relaxed) == value)
+                return false;
+
+            hiResParams[slot].store(value, std::memory_order_relaxed);
+            reportParameterValue(index, channel, value / kHiResScale);
+            return true;
+        }
+
+        if (params[slot].load(std::memory_order_relaxed) == value)
+            return false;
+
+        reportParameterValue(index, channel, value);
+        return true;
+    }
+
+   /**
+      Write all script events due within this block, reading them straight from the mapped script.
+      Waits are relative to when the previous event was due, or to the start of the block if it was late.
+    */
+    void playScript(const uint32_t frames, MidiEvent& outEvent)
+    {
+        const uint32_t count = script->getCount();
+        const double framesPerMicrosecond = getSampleRate() / 1000000.0;
+
+        for (; scriptIndex < count; ++scriptIndex)
+        {
+            const CommandScript::Event& event(script->getEvent(scriptIndex));
+
+            // the delay of an event is only added once, when it becomes the next one
+            if (! scriptDelayed)
+            {
+                scriptDue += event.delay * framesPerMicrosecond;
+                scriptDelayed = true;
+            }
+
+            if (scriptDue >= frames)
+                break;
+
+            if (! writeCommand(event.command, scriptDue > 0.0 ? static_cast<uint32_t>(scriptDue) : 0, outEvent))
+                break;
+
+            followScriptBinding(event.command);
+            scriptDelayed = false;
+        }
+
+        scriptDue = std::max(0.0, scriptDue - frames);
+
+        if (scriptIndex == count)
+            scriptPlaying = false;
+    }
+
+   /**
+      Make a binding sent by a script the current value on the control side, same as a change from the host,
+      so that the host and UI follow it and a later resync does not bring back the previous value.
+    */
+    void followScriptBinding(const Command& command)
+    {
+        if (command.type != kCommandParameter && command.type != kCommandHiResParameter)
+            return;
+        if (command.index >= kParamBindingCount || command.channel >= kMaxUnits)
+            return;
+
+        const uint32_t slot = getSlot(command.index, command.channel);
+
+        stopMorph(command.index, command.channel);
+
+        if (isHiResBinding(command.index))
+        {
+            const int value = command.type == kCommandHiResParameter
+                            ? std::clamp<int>(command.value, 0, HiResEncoder::kMaxValue)
+                            : d_roundToIntPositive(std::clamp(command.value, 0, 127) * kHiResScale);
+
+            setBindingValue(command.index, command.channel, value);
+            ramps[slot].jump(value);
+            pendingParams[slot] = value >> 7;
+        }
+        else if (command.type == kCommandParameter)
+        {
+            const int value = std::clamp(command.value, 0, 127);
+
+            setBindingValue(command.index, command.channel, value);
+            pendingParams[slot] = value;
+        }
+    }
+
+   /**
+      Send the next probe if it is due and the previous one was answered or timed out.
+    */
+    void sendProbe(const uint32_t frames, MidiEvent& outEvent)
+    {
+        const double sampleRate = getSampleRate();
+
+        if (probeWaiting && frameCounter > probeSentFrame + kProbeTimeout * sampleRate)
+        {
+            finishProbe();
+            setOutputParameter(kParamProbeLost, ++probeLost);
+        }
+
+        if (probeWaiting || probeNextFrame >= frameCounter + frames)
+            return;
+
+        // each probe uses a different value from the last one, so late answers are not mistaken for new ones
+        // CC probes also skip the value set by the user, which is sent back after them
+        const uint8_t channel = selectedUnit;
+
+        if (probeMode == kProbeCC && static_cast<int>(probeTag % 128) == pendingParams[getSlot(kProbeParam, channel)])
+            ++probeTag;
+
+        const Command command = probeMode == kProbeScene
+                              ? Command { kCommandAction, kActionScene, static_cast<int32_t>(probeTag % 4), channel }
+                              : Command { kCommandParameter, kProbeParam, static_cast<int32_t>(probeTag % 128), channel };
+
+        const uint32_t minFrame = probeNextFrame > frameCounter ? probeNextFrame - frameCounter : 0;
+
+        if (! writeCommand(command, minFrame, outEvent))
+            return;
+
+        ++probeTag;
+        probeStatus = outEvent.data[0];
+        probeCC = outEvent.data[1];
+        probeValue = outEvent.data[2];
+        probeUnit = channel;
+        probeSentFrame = frameCounter + outEvent.frame;
+        probeBlockEnd = frameCounter + frames;
+        probeNextFrame = probeSentFrame + getSetting(kParamProbeInterval) * sampleRate / 1000.0;
+        probeWaiting = true;
+    }
+
+   /**
+      Check if an incoming event is the answer to the probe we are waiting on.
+      Answers can only arrive on a later block, as input for this one was captured before we sent anything.
+    */
+    void checkProbeAnswer(const MidiEvent& event)
+    {
+        if (frameCounter < probeBlockEnd || event.size != 3)
+            return;
+        if (event.data[0] != probeStatus || event.data[1] != probeCC || event.data[2] != probeValue)
+            return;
+
+        const double sampleRate = getSampleRate();
+        const uint64_t latency = frameCounter + event.frame - probeSentFrame;
+
+        finishProbe();
+        probeLatencies.add(static_cast<uint32_t>(latency * 1000000.0 / sampleRate + 0.5));
+
+        setOutputParameter(kParamProbeLastLatency, latency);
+        setOutputParameter(kParamProbeMin, probeLatencies.getMin());
+        setOutputParameter(kParamProbeMedian, probeLatencies.getPercentile(50.0));
+        setOutputParameter(kParamProbeP99, probeLatencies.getPercentile(99.0));
+        setOutputParameter(kParamProbeCount, probeLatencies.getCount());
+
+        // all bins at once, the UI shows them as-is without keeping any history of its own
+        static constexpr const uint32_t kBinsPerOutput = kProbeHistogramBinWidth / 100;
+
+        for (uint32_t i = 0; i < kProbeHistogramBins; ++i)
+        {
+            const uint32_t last = i + 1 < kProbeHistogramBins ? (i + 1) * kBinsPerOutput : UINT32_MAX;
+            setOutputParameter(kParamProbeHistogram + i, probeLatencies.getCount(i * kBinsPerOutput, last));
+        }
+    }
+
+   /**
+      Stop waiting on the current probe, putting back the user value of the generic CC it changed.
+    */
+    void finishProbe()
+    {
+        if (! probeWaiting)
+            return;
+
+        probeWaiting = false;
+
+        if (probeStatus == (0xB0 | probeUnit) && probeCC == kParamToCC[kProbeParam])
+            updatedParams.set(getSlot(kProbeParam, probeUnit));
+    }
+
+    void resetProbe(const uint32_t mode)
+    {
+        finishProbe();
+
+        probeMode = mode;
+        probeTag = 0;
+        probeLost = 0;
+        probeNextFrame = frameCounter;
+        probeLatencies.clear();
+
+        for (uint32_t i = kParamProbeLastLatency; i <= kParamProbeHistogramLast; ++i)
+            setOutputParameter(i, 0.0f);
+    }
+
+   /**
+      Write messages from the stress generator at the requested rate, within this block.
+      Messages that cannot be sent in time are dropped instead of queued, so the achieved rate shows where we saturate.
+    */
+    void generateStress(const uint32_t frames, MidiEvent& outEvent)
+    {
+        const double sampleRate = getSampleRate();
+        const double period = sampleRate / std::max(1.0f, getSetting(kParamStressRate));
+
+        for (; stressPhase < frames; stressPhase += period)
+        {
+            Command command = stressGenerator.peek();
+            command.channel = selectedUnit;
+
+            if (! writeCommand(command, static_cast<uint32_t>(stressPhase), outEvent))
+                break;
+
+            if ((command.type == kCommandParameter || command.type == kCommandHiResParameter)
+                && command.index < kParamBindingCount)
+                stressBindings.set(getSlot(command.index, command.channel));
+
+            stressGenerator.advance();
+            ++stressSent;
+        }
+
+        if (stressPhase < frames)
+        {
+            const uint32_t missed = std::ceil((frames - stressPhase) / period);
+            stressMissed += missed;
+            stressPhase += missed * period;
+        }
+
+        stressPhase -= frames;
+        stressWindow += frames;
+
+        // update counters a few times per second
+        if (stressWindow >= sampleRate / 4)
+        {
+            setOutputParameter(kParamStressAchievedRate, stressSent * sampleRate / stressWindow);
+            setOutputParameter(kParamStressMissedRate, stressMissed * sampleRate / stressWindow);
+            stressSent = stressMissed = stressWindow = 0;
+        }
+    }
+
+   /**
+      Send the user values again for all bindings changed by the stress generator, which never touches them.
+      Only bindings the device has a different value for are actually sent.
+    */
+    void restoreStressBindings()
+    {
+        stressBindings.visit(0, kSlotCount, [this](const uint32_t slot) -> bool {
+            updatedParams.set(slot);
+            return true;
+        });
+        stressBindings.clear();
+    }
+
+    void resetStressCounters()
+    {
+        stressPhase = 0.0;
+        stressSent = stressMissed = stressWindow = 0;
+        setOutputParameter(kParamStressAchievedRate, 0.0f);
+        setOutputParameter(kParamStressMissedRate, 0.0f);
+    }
+
+   /**
+      Write an action or binding change from the timeline or stress generator, not earlier than @a minFrame.
+      Returns false if there is no room for it in this block, invalid commands are skipped and count as written.
+    */
+    bool writeCommand(const Command& command, const uint32_t minFrame, MidiEvent& outEvent)
+    {
+        switch (command.type)
+        {
+        case kCommandAction:
+            if (! encodeAction(command, outEvent))
+                return true;
+            return writeScheduledEvent(outEvent, minFrame);
+
+        case kCommandParameter:
+        case kCommandHiResParameter:
+            if (command.index >= kParamBindingCount || command.channel >= kMaxUnits)
+                return true;
+            if (isHiResReservedCC(hiResMode, kParamToCC[command.index]))
+                return true;
+            outEvent.size = 3;
+            outEvent.data[0] = 0xB0 | command.channel;
+            outEvent.data[1] = kParamToCC[command.index];
+            outEvent.data[2] = std::clamp(command.value, 0, 127);
+            if (command.type == kCommandHiResParameter)
+            {
+                if (! isHiResBinding(command.index))
+                    return true;
+
+                const uint16_t value = std::clamp<int>(command.value, 0, HiResEncoder::kMaxValue);
+
+                if (HiResEncoder::supports(hiResMode, kParamToCC[command.index]))
+                    return writeHiResBinding(getSlot(command.index, command.channel), value, minFrame, outEvent);
+
+                outEvent.data[2] = value >> 7;
+            }
+            if (! writeScheduledEvent(outEvent, minFrame))
+                return false;
+            lastSentParams[getSlot(command.index, command.channel)] = outEvent.data[2];
+            return true;
+        }
+
+        return true;
+    }
+
+    void setRampTarget(const uint32_t slot, const double target, const uint32_t frames) noexcept
+    {
+        ramps[slot].setTarget(target, frames);
+        activeRamps.set(slot);
+    }
+
+   /**
+      Write ramping binding slots in [@a first, @a last) at regular intervals within the block.
+      Intervals go first so that bindings ramping at the same time share the link evenly.
+      Returns false if there is no room left in this block, in which case ramps are resumed on the next one.
+    */
+    bool writeRamps(const uint32_t first, const uint32_t last, const uint32_t frames, MidiEvent& outEvent)
+    {
+        const uint32_t interval = std::max(1u, d_roundToUnsignedInt(kRampInterval * getSampleRate() / 1000.0));
+
+        for (uint32_t frame = 0; frame < frames; frame += interval)
+        {
+            bool pending = false;
+
+            const bool written = updatedParams.visit(first, last, [&](const uint32_t slot) -> bool {
+                if (! writeRampValue(slot, frame, outEvent))
+                {
+                    blockRoute(slot % kMaxUnits);
+                    return ! areAllRoutesBlocked();
+                }
+
+                if (ramps[slot].isActiveAt(frame))
+                    pending = true;
+                else
+                    updatedParams.reset(slot);
+
+                return true;
+            });
+
+            if (! written)
+                return false;
+            if (! pending)
+                break;
+        }
+
+        return true;
+    }
+
+   /**
+      Write the value of a ramping binding slot @a frame frames into the block, quantized to the current resolution.
+      Nothing is written if the device already has the quantized value.
+    */
+    bool writeRampValue(const uint32_t slot, const uint32_t frame, MidiEvent& outEvent)
+    {
+        const uint8_t cc = kParamToCC[slot / kMaxUnits];
+        const double value = ramps[slot].getValueAt(frame);
+
+        if (HiResEncoder::supports(hiResMode, cc))
+            return writeHiResBinding(slot, static_cast<uint16_t>(value + 0.5), frame, outEvent);
+
+        const int value7 = std::min(127, static_cast<int>(value / kHiResScale + 0.5));
+
+        if (lastSentParams[slot] == value7)
+            return true;
+
+        outEvent.size = 3;
+        outEvent.data[0] = 0xB0 | (slot % kMaxUnits);
+        outEvent.data[1] = cc;
+        outEvent.data[2] = value7;
+
+        if (! writeScheduledEvent(outEvent, frame))
+            return false;
+
+        lastSentParams[slot] = value7;
+        return true;
+    }
+
+   /**
+      Write a binding slot in high resolution, with as few messages as possible given what the device last received.
+      Returns false if there is no room for all of them in this block, what was written is remembered for the retry.
+    */
+    bool writeHiResBinding(const uint32_t slot, const uint16_t value, const uint32_t minFrame, MidiEvent& outEvent)
+    {
+        const uint8_t channel = slot % kMaxUnits;
+        const HiResEncoder& hiResEncoder(hiResEncoders[channel]);
+
+        outEvent.size = 3;
+        outEvent.data[0] = 0xB0 | channel;
+
+        // one message at a time, as thru events written in between can change what the device has
+        while (hiResEncoder.getNext(hiResMode, kParamToCC[slot / kMaxUnits], value, outEvent.data[1], outEvent.data[2]))
+        {
+            if (! writeScheduledEvent(outEvent, minFrame))
+                return false;
+        }
+
+        lastSentParams[slot] = value >> 7;
+        return true;
+    }
+
+   /**
+      Handle a CC received from the unit on @a channel, updating our state to match it without sending anything back.
+      Only the selected unit is reported to the host, others are just kept track of.
+    */
+    void handleFeedbackCC(const uint8_t channel, const uint8_t cc, const uint8_t value)
+    {
+        const uint8_t index = kCCToParam[cc];
+        const bool selected = channel == selectedUnit;
+
+        if (index == kCCUnbound)
+        {
+            if (! selected)
+                return;
+
+            switch (cc)
+            {
+            case 85:
+                setOutputParameter(kParamDeviceMode, std::min<uint8_t>(value, 2));
+                break;
+            case 102:
+                setOutputParameter(kParamDeviceBank, value);
+                break;
+            case 107:
+                setOutputParameter(kParamDeviceScene, std::min<uint8_t>(value, 3));
+                break;
+            }
+            return;
+        }
+
+        // part of high resolution messages, not a generic binding
+        if (isHiResReservedCC(hiResMode, cc))
+            return;
+
+        const uint32_t slot = getSlot(index, channel);
+
+        // echo of what we sent last, or nothing new
+        if (lastSentParams[slot] == value)
+            return;
+
+        lastSentParams[slot] = value;
+
+        if (isHiResBinding(index))
+        {
+            hiResEncoders[channel].forget(cc);
+            hiResParams[slot].store(value * kHiResScale, std::memory_order_relaxed);
+            ramps[slot].jump(value * kHiResScale);
+        }
+
+        if (params[slot].load(std::memory_order_relaxed) == value)
+            return;
+
+        // device wins over anything still waiting to be sent
+        updatedParams.reset(slot);
+        stopMorph(index, channel);
+        reportParameterValue(index, channel, value);
+    }
+
+   /**
+      Store a binding value changed on the realtime side, requesting the host to follow it for the selected unit.
+      The host sending it back is then ignored, as the value came from here.
+    */
+    void reportParameterValue(const uint32_t index, const uint8_t channel, const float value)
+    {
+        const uint32_t slot = getSlot(index, channel);
+        const int ivalue = d_roundToIntPositive(value);
+
+        params[slot].store(ivalue, std::memory_order_relaxed);
+
+        if (channel == selectedUnit && canRequestParameterValueChanges())
+        {
+            feedbackParams[slot].store(ivalue, std::memory_order_release);
+
+            if (! requestParameterValueChange(index, value))
+                feedbackParams[slot].store(-1, std::memory_order_relaxed);
+        }
+    }
+
+   /**
+      Write all allowed thru events up to and including @a frame, straight from the host input buffer.
+      Returns true if any event was written.
+    */
+    bool writeThruEvents(const uint32_t frame)
+    {
+        bool written = false;
+
+        for (; thruIndex < thruEventCount; ++thruIndex)
+        {
+            const MidiEvent& event(thruEvents[thruIndex]);
+
+            if (event.frame > frame)
+                break;
+            if (! isThruAllowed(event))
+                continue;
+
+            // out of room, drop the remaining thru events
+            if (! writeMidiEvent(event))
+            {
+                stats.addRejected();
+                stats.addDropped(thruEventCount - thruIndex);
+                thruIndex = thruEventCount;
+                break;
+            }
+
+            stats.addEmitted();
+            lastFrame = std::max(lastFrame, event.frame);
+
+            // system messages have no channel, they go out on every port
+            const uint8_t* const data = event.size > MidiEvent::kDataSize ? event.dataExt : event.data;
+            const bool isSystem = data[0] >= 0xF0;
+
+            for (uint32_t r = isSystem ? 0 : getRouteIndex(data[0] & 0x0F), count = getRouteCount(); r < count; ++r)
+            {
+                OutputRoute& route(routes[r]);
+                route.scheduler.reserve(event.frame, useRunningStatus ? route.encoder.getEncodedSize(data, event.size)
+                                                                      : event.size);
+                route.encoder.commit(data, event.size);
+
+                if (! isSystem)
+                    break;
+            }
+
+            if (event.size == 3 && (data[0] & 0xF0) == 0xB0)
+            {
+                const uint8_t channel = data[0] & 0x0F;
+                const uint8_t index = kCCToParam[data[1] & 0x7f];
+
+                if (index != kCCUnbound)
+                    lastSentParams[getSlot(index, channel)] = data[2] & 0x7f;
+
+                hiResEncoders[channel].observe(data[1] & 0x7f, data[2] & 0x7f);
+            }
+            written = true;
+        }
+
+        return written;
+    }
+
+    bool isThruAllowed(const MidiEvent& event) const noexcept
+    {
+        if (event.size == 0)
+            return false;
+
+        const uint8_t* const data = event.size > MidiEvent::kDataSize ? event.dataExt : event.data;
+        const uint8_t status = data[0];
+
+        // system messages have no channel
+        if (status >= 0xF0)
+            return true;
+
+        if (thruFilter.channel != 0 && (status & 0x0F) + 1 != thruFilter.channel)
+            return false;
+
+        if ((status & 0xF0) != 0xB0 || event.size != 3)
+            return true;
+
+        const uint8_t cc = data[1] & 0x7f;
+
+        if (cc < thruFilter.firstCC || cc > thruFilter.lastCC)
+            return false;
+
+        return ! isThruConflict(status, cc);
+    }
+
+   /**
+      Check if a CC passed through would conflict with one we are sending in this same block.
+    */
+    bool isThruConflict(const uint8_t status, const uint8_t cc) const noexcept
+    {
+        if (thruEventCount == 0 || ! thruFilter.override || (status & 0xF0) != 0xB0)
+            return false;
+
+        const uint8_t index = kCCToParam[cc];
+        return index != kCCUnbound && thruConflicts.test(getSlot(index, status & 0x0F));
+    }
+
+    uint32_t getRouteCount() const noexcept
+    {
+        return routing == kRoutingPerUnit ? kMaxUnits : 1;
+    }
+
+    uint32_t getRouteIndex(const uint8_t channel) const noexcept
+    {
+        return routing == kRoutingPerUnit ? channel : 0;
+    }
+
+    void blockRoute(const uint8_t channel) noexcept
+    {
+        blockedRoutes |= 1u << getRouteIndex(channel);
+    }
+
+    bool areAllRoutesBlocked() const noexcept
+    {
+        const uint32_t mask = (1u << getRouteCount()) - 1;
+        return (blockedRoutes & mask) == mask;
+    }
+
+   /**
+      Check if every route can take @a count more actions, for batches which may address any unit.
+    */
+    bool hasRoomForActions(const uint32_t count) const noexcept
+    {
+        for (uint32_t r = 0, routeCount = getRouteCount(); r < routeCount; ++r)
+        {
+            if (routes[r].pendingActions.getFreeCount() < count)
+                return false;
+        }
+
+        return true;
+    }
+
+    uint32_t getUnitCount() const noexcept
+    {
+        return std::clamp<uint32_t>(d_roundToUnsignedInt(getSetting(kParamUnitCount)), 1, kMaxUnits);
+    }
+
+   /**
+      Get the unit addressed by binding parameters and single actions, as its 0-based channel.
+      Can be called from any thread.
+    */
+    uint8_t getSelectedUnit() const noexcept
+    {
+        return std::clamp<uint32_t>(d_roundToUnsignedInt(getSetting(kParamUnit)), 1, getUnitCount()) - 1;
+    }
+
+    float getSetting(const uint32_t index) const noexcept
+    {
+        return extraParams[index - kParamBindingCount].load(std::memory_order_relaxed);
+    }
+
+    void setOutputParameter(const uint32_t index, const float value) noexcept
+    {
+        extraParams[index - kParamBindingCount].store(value, std::memory_order_relaxed);
+    }
+
+   /**
+      Write an event at the next frame allowed by the scheduler of its route, which is set in @a outEvent.
+      Returns false if the event does not fit in the current block, its route is blocked or the host has no more room.
+    */
+    bool writeScheduledEvent(MidiEvent& outEvent, const uint32_t minFrame = 0)
+    {
+        const uint32_t routeIndex = getRouteIndex(outEvent.data[0] & 0x0F);
+
+        if ((blockedRoutes >> routeIndex) & 1)
+            return false;
+
+        OutputRoute& route(routes[routeIndex]);
+        uint32_t wireSize;
+
+        // thru events placed before this one may use up link bandwidth, so try again until stable
+        // routes are paced independently, but the host still needs all events in order
+        do {
+            wireSize = useRunningStatus ? route.encoder.getEncodedSize(outEvent.data, outEvent.size) : outEvent.size;
+
+            if (! route.scheduler.getNextFrame(wireSize, outEvent.frame, std::max(minFrame, lastFrame)))
+            {
+                stats.addDeferred();
+                return false;
+            }
+
+        } while (writeThruEvents(outEvent.frame));
+
+        if (! writeMidiEvent(outEvent))
+        {
+            blockedRoutes = ~0u;
+            stats.addRejected();
+            stats.addDeferred();
+            return false;
+        }
+
+        stats.addEmitted();
+        route.scheduler.advance(outEvent.frame, wireSize);
+        route.encoder.commit(outEvent.data, outEvent.size);
+        lastFrame = outEvent.frame;
+
+        if (outEvent.size == 3 && (outEvent.data[0] & 0xF0) == 0xB0)
+            hiResEncoders[outEvent.data[0] & 0x0F].observe(outEvent.data[1], outEvent.data[2]);
+
+        trackLocation(outEvent.data, outEvent.size);
+        return true;
+    }
+
+   /**
+      Keep track of the bank, preset, scene and mode of a unit, from a message sent to it or received from it.
+      Relative changes make the location unknown, until the unit reports it.
+    */
+    void trackLocation(const uint8_t* const data, const uint32_t size) noexcept
+    {
+        std::atomic<int>* const location = locations[data[0] & 0x0F];
+
+        if (size == 2 && (data[0] & 0xF0) == 0xC0)
+        {
+            location[kActionPreset].store(data[1] & 0x7f, std::memory_order_relaxed);
+            return;
+        }
+
+        if (size != 3 || (data[0] & 0xF0) != 0xB0)
+            return;
+
+        switch (data[1])
+        {
+        case 85:
+            location[kActionMode].store(std::min<uint8_t>(data[2], 2), std::memory_order_relaxed);
+            break;
+        case 102:
+            location[kActionBank].store(data[2] & 0x7f, std::memory_order_relaxed);
+            break;
+        case 103:
+        case 104:
+            location[kActionBank].store(-1, std::memory_order_relaxed);
+            break;
+        case 105:
+        case 106:
+            location[kActionPreset].store(-1, std::memory_order_relaxed);
+            break;
+        case 107:
+            location[kActionScene].store(std::min<uint8_t>(data[2], 3), std::memory_order_relaxed);
+            break;
+        case 108:
+        case 109:
+            location[kActionScene].store(-1, std::memory_order_relaxed);
+            break;
+        }
+    }
+
+   /**
+      Queue the known locations of all units in use as actions, so they are sent before any binding.
+    */
+    void queueLocations()
+    {
+        for (uint32_t unit = 0; unit < unitCount; ++unit)
+        {
+            CommandFifo<PendingAction, 256>& pendingActions(routes[getRouteIndex(unit)].pendingActions);
+
+            for (const uint8_t action : kLocationOrder)
+            {
+                const int value = locations[unit][action].load(std::memory_order_relaxed);
+
+                if (value >= 0)
+                    pendingActions.push({ { kCommandAction, action, value, static_cast<uint8_t>(unit) }, frameCounter });
+            }
+        }
+    }
+
+   /**
+      Encode an action command into a MIDI event, returns false if the action results in no event.
+    */
+    static bool encodeAction(const Command& action, MidiEvent& outEvent) noexcept
+    {
+        outEvent.size = 3;
+        outEvent.data[0] = 0xB0 | (action.channel & 0x0F);
+
+        switch (static_cast<Actions>(action.index))
+        {
+        case kActionBank:
+            switch (action.value)
+            {
+            default:
+                outEvent.data[1] = 102;
+                outEvent.data[2] = std::clamp(action.value, 0, 127);
+                break;
+            case kActionStepNext:
+                outEvent.data[1] = 103;
+                outEvent.data[2] = 0;
+                break;
+            case kActionStepPrevious:
+                outEvent.data[1] = 104;
+                outEvent.data[2] = 0;
+                break;
+            }
+            break;
+        case kActionPreset:
+            switch (action.value)
+            {
+            default:
+                outEvent.size = 2;
+                outEvent.data[0] = 0xC0 | (action.channel & 0x0F);
+                outEvent.data[1] = std::clamp(action.value, 0, 127);
+                break;
+            case kActionStepNext:
+                outEvent.data[1] = 105;
+                outEvent.data[2] = 0;
+                break;
+            case kActionStepPrevious:
+                outEvent.data[1] = 106;
+                outEvent.data[2] = 0;
+                break;
+            }
+            break;
+        case kActionScene:
+            switch (action.value)
+            {
+            case 0 ... 3:
+                outEvent.data[1] = 107;
+                outEvent.data[2] = action.value;
+                break;
+            case kActionStepNext:
+                outEvent.data[1] = 108;
+                outEvent.data[2] = 0;
+                break;
+            case kActionStepPrevious:
+                outEvent.data[1] = 109;
+                outEvent.data[2] = 0;
+                break;
+            default:
+                return false;
+            }
+            break;
+        case kActionMode:
+            outEvent.data[1] = 85;
+            outEvent.data[2] = std::clamp(action.value, 0, 2);
+            break;
+        case kActionTuner:
+            outEvent.data[1] = 86;
+            outEvent.data[2] = 0;
+            break;
+        default:
+            return false;
+        }
+
+        return true;
     }
 
     // ----------------------------------------------------------------------------------------------------------------
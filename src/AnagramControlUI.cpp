@@ -8,11 +8,63 @@
 #include "DistrhoStandaloneUtils.hpp"
 
 #include <algorithm>
+#include <cfloat>
+#include <cstring>
 
 START_NAMESPACE_DISTRHO
 
 // --------------------------------------------------------------------------------------------------------------------
 
+// slider labels of all bindings, built at compile time so that drawing them never allocates
+struct BindingLabels {
+    char names[kParamBindingCount][20];
+};
+
+static constexpr uint appendText(char* const label, uint pos, const char* text) noexcept
+{
+    while (*text != '\0')
+        label[pos++] = *text++;
+    return pos;
+}
+
+static constexpr uint appendNumber(char* const label, uint pos, const uint number) noexcept
+{
+    if (number >= 10)
+        pos = appendNumber(label, pos, number / 10);
+    label[pos++] = '0' + number % 10;
+    return pos;
+}
+
+static constexpr BindingLabels makeBindingLabels()
+{
+    BindingLabels labels = {};
+
+    for (uint i = 0; i < kParamBindingCount; ++i)
+    {
+        char* const label = labels.names[i];
+        uint pos = 0;
+
+        /**/ if (i <= kParamPot6)
+            pos = appendNumber(label, appendText(label, pos, "Pot "), i - kParamPot1 + 1);
+        else if (i <= kParamFoot3)
+            pos = appendNumber(label, appendText(label, pos, "Foot "), i - kParamFoot1 + 1);
+        else if (i == kParamExpPedal)
+            pos = appendText(label, pos, "Exp.Pedal");
+
+        // fixed bindings show their CC along with the name
+        if (i < kParamCCs)
+            appendText(label, appendNumber(label, appendText(label, pos, " (CC "), kParamToCC[i]), ")");
+        else
+            appendNumber(label, appendText(label, pos, "CC "), kParamToCC[i]);
+    }
+
+    return labels;
+}
+
+static constexpr const BindingLabels kBindingLabels = makeBindingLabels();
+
+// --------------------------------------------------------------------------------------------------------------------
+
 class AnagramControlUI : public UI
 {
     static constexpr const char* const kBankNames[] = {
@@ -21,6 +73,7 @@ class AnagramControlUI : public UI
         "29", "30", "31", "32", "33", "34", "35", "36", "37", "38", "39", "40", "41", "42",
     };
     static_assert(ARRAY_SIZE(kBankNames) == 42, "wrong number of banks");
+    static_assert(ARRAY_SIZE(kBankNames) >= kSnapshotCount, "snapshot names are taken from bank names");
     static constexpr const char* const kPresetNames[] = {
         "  1", "  2", "  3", "  4", "  5", "  6", "  7", "  8", "  9", " 10", " 11", " 12", " 13", " 14",
         " 15", " 16", " 17", " 18", " 19", " 20", " 21", " 22", " 23", " 24", " 25", " 26", " 27", " 28",
@@ -33,9 +86,99 @@ class AnagramControlUI : public UI
         "113", "114", "115", "116", "117", "118", "119", "120", "121", "122", "123", "124", "125", "126",
     };
     static_assert(ARRAY_SIZE(kPresetNames) == 126, "wrong number of presets");
-    int params[kParamCount] = {};
+    static constexpr const char* const kUnitNames[] = {
+        "Ch 1", "Ch 2", "Ch 3", "Ch 4", "Ch 5", "Ch 6", "Ch 7", "Ch 8",
+        "Ch 9", "Ch 10", "Ch 11", "Ch 12", "Ch 13", "Ch 14", "Ch 15", "Ch 16",
+    };
+    static_assert(ARRAY_SIZE(kUnitNames) == kMaxUnits, "wrong number of units");
+    static constexpr const char* const kRoutingNames[] = {
+        "Shared link", "Link per unit",
+    };
+    static constexpr const char* const kHiResModeNames[] = {
+        "Off", "14-bit CC", "NRPN",
+    };
+    static constexpr const char* const kTimelineStateNames[] = {
+        "Stopped", "Recording", "Playing",
+    };
+    static constexpr const char* const kStressModeNames[] = {
+        "Off", "CC Sweep", "Increment Storm", "Random Mix",
+    };
+    static constexpr const char* const kProbeModeNames[] = {
+        "Off", "Scene", "Generic CC",
+    };
+    // panels showing output parameters that change on their own, only repainted for them while visible
+    enum OutputPanels {
+        kPanelStress,
+        kPanelProbe,
+        kPanelStats,
+        kPanelCount,
+        kPanelNone = kPanelCount
+    };
+    // generic CC panel
+    static constexpr const uint kGenericCCCount = kParamBindingCount - kParamCCs;
+    static constexpr const uint kRecentCCCount = 16;
+    // bindings of each unit, host parameters always refer to the selected one
+    int unitParams[kMaxUnits][kParamBindingCount] = {};
+    float unitHiResParams[kMaxUnits][kParamCCs] = {};
+    int unitCount = 1;
+    int selectedUnit = 0;
+    int outputRouting = 0;
+    float eventSpacing = 1.0f;
+    int linkRate = 31250;
+    bool runningStatus = false;
+    int hiResMode = 0;
+    float smoothing = 0.0f;
+    float morphTime = 1000.0f;
+    float resyncInterval = 0.0f;
+    bool resendOnActivate = false;
+    bool thru = false;
+    int thruChannel = 0;
+    int thruFirstCC = 0;
+    int thruLastCC = 127;
+    bool thruOverride = true;
+    float actionLatency = 0.0f;
+    int deviceBank = 0;
+    int devicePreset = 0;
+    int deviceScene = 0;
+    int deviceMode = 0;
+    bool timelineSync = true;
+    int timelineState = 0;
+    int timelineEvents = 0;
+    int timelinePosition = 0;
+    char timelinePath[256] = {};
+    bool scriptPlaying = false;
+    int scriptEvents = 0;
+    int scriptPosition = 0;
+    char scriptPath[256] = {};
+    int stressMode = 0;
+    int stressRate = 100;
+    int stressSeed = 1;
+    float stressAchievedRate = 0.0f;
+    float stressMissedRate = 0.0f;
+    int probeMode = 0;
+    float probeInterval = 500.0f;
+    int probeLastLatency = 0;
+    float probeMin = 0.0f;
+    float probeMedian = 0.0f;
+    float probeP99 = 0.0f;
+    int probeCount = 0;
+    int probeLost = 0;
+    float probeHistogram[kProbeHistogramBins] = {};
+    float stats[kParamStatsRunMax - kParamStatsEmitted + 1] = {};
     int bank = 0;
     int preset = 0;
+    int snapshot = 0;
+    int morphTarget = 1;
+    bool repaintPending = false;
+    bool panelVisible[kPanelCount] = { true, true, true };
+    // generic CC panel, rows are the generic CCs (from kParamCCs) shown after filtering, updated only when dirty
+    char ccFilter[8] = {};
+    bool ccRecentOnly = false;
+    bool ccRowsDirty = true;
+    uint8_t ccRows[kGenericCCCount] = {};
+    uint ccRowCount = 0;
+    uint8_t ccRecent[kRecentCCCount] = {}; // most recent first
+    uint ccRecentCount = 0;
 
     // ----------------------------------------------------------------------------------------------------------------
 
@@ -47,8 +190,14 @@ public:
     AnagramControlUI()
     {
         // match DSP default state
-        for (int i = kParamPot1; i <= kParamPot6; ++i)
-            params[i] = 63;
+        for (uint unit = 0; unit < kMaxUnits; ++unit)
+        {
+            for (int i = kParamPot1; i <= kParamPot6; ++i)
+            {
+                unitParams[unit][i] = 63;
+                unitHiResParams[unit][i] = 63.0f;
+            }
+        }
 
         // set minimum size constraint
         const double scaleFactor = getScaleFactor();
@@ -71,8 +220,245 @@ protected:
     {
         DISTRHO_SAFE_ASSERT_RETURN(index < kParamCount,);
 
-        params[index] = std::clamp<int>(d_roundToIntPositive(value), 0, 127);
-        repaint();
+        switch (index)
+        {
+        case kParamEventSpacing:
+            eventSpacing = value;
+            break;
+        case kParamLinkRate:
+            linkRate = d_roundToIntPositive(value);
+            break;
+        case kParamRunningStatus:
+            runningStatus = value > 0.5f;
+            break;
+        case kParamHiResMode:
+            hiResMode = std::clamp<int>(d_roundToIntPositive(value), 0, ARRAY_SIZE(kHiResModeNames) - 1);
+            break;
+        case kParamSmoothing:
+            smoothing = value;
+            break;
+        case kParamMorphTime:
+            morphTime = value;
+            break;
+        case kParamResyncInterval:
+            resyncInterval = value;
+            break;
+        case kParamResendOnActivate:
+            resendOnActivate = value > 0.5f;
+            break;
+        case kParamUnitCount:
+            unitCount = std::clamp(d_roundToIntPositive(value), 1, static_cast<int>(kMaxUnits));
+            break;
+        case kParamUnit:
+            selectedUnit = std::clamp(d_roundToIntPositive(value), 1, static_cast<int>(kMaxUnits)) - 1;
+            break;
+        case kParamOutputRouting:
+            outputRouting = d_roundToIntPositive(value);
+            break;
+        case kParamThru:
+            thru = value > 0.5f;
+            break;
+        case kParamThruChannel:
+            thruChannel = d_roundToIntPositive(value);
+            break;
+        case kParamThruFirstCC:
+            thruFirstCC = d_roundToIntPositive(value);
+            break;
+        case kParamThruLastCC:
+            thruLastCC = d_roundToIntPositive(value);
+            break;
+        case kParamThruOverride:
+            thruOverride = value > 0.5f;
+            break;
+        case kParamActionLatency:
+            actionLatency = value;
+            break;
+        case kParamDeviceBank:
+            deviceBank = d_roundToIntPositive(value);
+            break;
+        case kParamDevicePreset:
+            devicePreset = d_roundToIntPositive(value);
+            break;
+        case kParamDeviceScene:
+            deviceScene = d_roundToIntPositive(value);
+            break;
+        case kParamDeviceMode:
+            deviceMode = d_roundToIntPositive(value);
+            break;
+        case kParamTimelineSync:
+            timelineSync = value > 0.5f;
+            break;
+        case kParamTimelineState:
+            timelineState = std::clamp<int>(d_roundToIntPositive(value), 0, ARRAY_SIZE(kTimelineStateNames) - 1);
+            break;
+        case kParamTimelineEvents:
+            timelineEvents = d_roundToIntPositive(value);
+            break;
+        case kParamTimelinePosition:
+            timelinePosition = d_roundToIntPositive(value);
+            break;
+        case kParamScriptState:
+            scriptPlaying = value > 0.5f;
+            break;
+        case kParamScriptEvents:
+            scriptEvents = d_roundToIntPositive(value);
+            break;
+        case kParamScriptPosition:
+            scriptPosition = d_roundToIntPositive(value);
+            break;
+        case kParamStressMode:
+            stressMode = std::clamp<int>(d_roundToIntPositive(value), 0, ARRAY_SIZE(kStressModeNames) - 1);
+            break;
+        case kParamStressRate:
+            stressRate = d_roundToIntPositive(value);
+            break;
+        case kParamStressSeed:
+            stressSeed = d_roundToIntPositive(value);
+            break;
+        case kParamStressAchievedRate:
+            stressAchievedRate = value;
+            break;
+        case kParamStressMissedRate:
+            stressMissedRate = value;
+            break;
+        case kParamProbeMode:
+            probeMode = std::clamp<int>(d_roundToIntPositive(value), 0, ARRAY_SIZE(kProbeModeNames) - 1);
+            break;
+        case kParamProbeInterval:
+            probeInterval = value;
+            break;
+        case kParamProbeLastLatency:
+            probeLastLatency = d_roundToIntPositive(value);
+            break;
+        case kParamProbeMin:
+            probeMin = value;
+            break;
+        case kParamProbeMedian:
+            probeMedian = value;
+            break;
+        case kParamProbeP99:
+            probeP99 = value;
+            break;
+        case kParamProbeCount:
+            probeCount = d_roundToIntPositive(value);
+            break;
+        case kParamProbeLost:
+            probeLost = d_roundToIntPositive(value);
+            break;
+        case kParamProbeHistogram ... kParamProbeHistogramLast:
+            probeHistogram[index - kParamProbeHistogram] = value;
+            break;
+        case kParamStatsEmitted ... kParamStatsRunMax:
+            stats[index - kParamStatsEmitted] = value;
+            break;
+        default:
+            {
+                const int ivalue = std::clamp<int>(d_roundToIntPositive(value), 0, 127);
+                int& param(unitParams[getSelectedUnit()][index]);
+
+                if (index >= kParamCCs && param != ivalue)
+                    addRecentCC(index - kParamCCs);
+
+                param = ivalue;
+            }
+            if (index < kParamCCs)
+                unitHiResParams[getSelectedUnit()][index] = std::clamp(value, 0.0f, 127.0f);
+            break;
+        }
+
+        // hosts may send lots of changes at once, such as on session load, so repaint only once per idle cycle
+        // statistics and such keep changing while the plugin runs, they do not need a repaint while scrolled away
+        const uint panel = getOutputPanel(index);
+
+        if (panel == kPanelNone || panelVisible[panel])
+            repaintPending = true;
+    }
+
+    static uint getOutputPanel(const uint32_t index) noexcept
+    {
+        switch (index)
+        {
+        case kParamStressAchievedRate:
+        case kParamStressMissedRate:
+            return kPanelStress;
+        case kParamProbeLastLatency ... kParamProbeHistogramLast:
+            return kPanelProbe;
+        case kParamStatsEmitted ... kParamStatsRunMax:
+            return kPanelStats;
+        default:
+            return kPanelNone;
+        }
+    }
+
+   /**
+      Update the visibility of an output panel, drawn from @a start up to the current cursor position.
+    */
+    void updatePanelVisibility(const uint panel, const ImVec2& start)
+    {
+        panelVisible[panel] = ImGui::IsRectVisible(start, ImVec2(start.x + 1, ImGui::GetCursorScreenPos().y));
+    }
+
+   /**
+      Move a generic CC to the front of the recently changed list, dropping the oldest one if full.
+    */
+    void addRecentCC(const uint8_t cc)
+    {
+        uint pos = std::find(ccRecent, ccRecent + ccRecentCount, cc) - ccRecent;
+
+        if (pos == ccRecentCount)
+        {
+            if (ccRecentCount < kRecentCCCount)
+                ++ccRecentCount;
+            else
+                pos = kRecentCCCount - 1;
+        }
+
+        std::copy_backward(ccRecent, ccRecent + pos, ccRecent + pos + 1);
+        ccRecent[0] = cc;
+
+        if (ccRecentOnly)
+            ccRowsDirty = true;
+    }
+
+   /**
+      Rebuild the rows of the generic CC panel from the current filter and view.
+    */
+    void updateCCRows()
+    {
+        const uint count = ccRecentOnly ? ccRecentCount : kGenericCCCount;
+
+        ccRowCount = 0;
+        ccRowsDirty = false;
+
+        for (uint i = 0; i < count; ++i)
+        {
+            const uint8_t cc = ccRecentOnly ? ccRecent[i] : i;
+
+            if (ccFilter[0] == '\0' || std::strstr(kBindingLabels.names[kParamCCs + cc], ccFilter) != nullptr)
+                ccRows[ccRowCount++] = cc;
+        }
+    }
+
+    // same as the plugin side, the selected unit is limited to the ones in use
+    int getSelectedUnit() const noexcept
+    {
+        return std::min(selectedUnit, unitCount - 1);
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // UI Callbacks
+
+   /**
+      Idle callback, called at regular intervals.
+      Repaints for parameter changes happen here, nothing is drawn while nothing changes.
+    */
+    void uiIdle() override
+    {
+        if (repaintPending)
+        {
+            repaintPending = false;
+            repaint();
+        }
     }
 
     // ----------------------------------------------------------------------------------------------------------------
@@ -87,12 +473,41 @@ protected:
         const uint width1 = 330 * scaleFactor;
         const uint width2 = getWidth() - width1;
         const uint height = getHeight();
-        String name;
+        const int unit = getSelectedUnit();
+        int* const params = unitParams[unit];
+        float* const hiResParams = unitHiResParams[unit];
 
         ImGui::SetNextWindowPos(ImVec2(0, 0));
         ImGui::SetNextWindowSize(ImVec2(width1, height));
         if (ImGui::Begin("Hardcoded", nullptr, ImGuiWindowFlags_AlwaysAutoResize | ImGuiWindowFlags_NoDecoration))
         {
+            ImGui::SeparatorText("Unit");
+            {
+                int newUnit = unit;
+                ImGui::SetNextItemWidth(80 * scaleFactor);
+                if (ImGui::Combo("##unit", &newUnit, kUnitNames, unitCount))
+                {
+                    selectedUnit = newUnit;
+                    setParameterValue(kParamUnit, newUnit + 1);
+                }
+                ImGui::SameLine();
+                ImGui::SetNextItemWidth(120 * scaleFactor);
+                if (ImGui::SliderInt("Units", &unitCount, 1, kMaxUnits))
+                {
+                    if (ImGui::IsItemActivated())
+                        editParameter(kParamUnitCount, true);
+
+                    setParameterValue(kParamUnitCount, unitCount);
+                }
+
+                if (ImGui::IsItemDeactivated())
+                    editParameter(kParamUnitCount, false);
+
+                ImGui::SetNextItemWidth(140 * scaleFactor);
+                if (ImGui::Combo("Routing", &outputRouting, kRoutingNames, ARRAY_SIZE(kRoutingNames)))
+                    setParameterValue(kParamOutputRouting, outputRouting);
+            }
+
             ImGui::SeparatorText("Bank Preloading");
             ImGui::SetNextItemWidth(64 * scaleFactor);
             ImGui::Combo("##bank", &bank, kBankNames, ARRAY_SIZE(kBankNames));
@@ -158,18 +573,48 @@ protected:
                 setState("tuner", "");
             }
 
+            ImGui::SeparatorText("Snapshots");
+            ImGui::SetNextItemWidth(64 * scaleFactor);
+            ImGui::Combo("##snapshot", &snapshot, kBankNames, kSnapshotCount);
+            ImGui::SameLine();
+            if (ImGui::Button("Store##snapshot"))
+                setState("snapshot_store", String(snapshot + 1));
+            ImGui::SameLine();
+            if (ImGui::Button("Recall##snapshot"))
+                setState("snapshot_recall", String(snapshot + 1));
+            ImGui::SameLine();
+            ImGui::SeparatorEx(ImGuiSeparatorFlags_Vertical);
+            ImGui::SameLine();
+            if (ImGui::Button("Morph into##snapshot"))
+            {
+                String numbers(snapshot + 1);
+                numbers += " ";
+                numbers += String(morphTarget + 1);
+                setState("snapshot_morph", numbers);
+            }
+            ImGui::SameLine();
+            ImGui::SetNextItemWidth(64 * scaleFactor);
+            ImGui::Combo("##morph_target", &morphTarget, kBankNames, kSnapshotCount);
+
+            if (ImGui::InputFloat("Morph time (ms)", &morphTime, 0.0f, 0.0f, "%.0f"))
+            {
+                morphTime = std::clamp(morphTime, 0.0f, 60000.0f);
+                setParameterValue(kParamMorphTime, morphTime);
+            }
+
             ImGui::SeparatorText("CC Bindings");
 
+            // fractional values only make a difference in high resolution
+            const char* const hiResFormat = hiResMode != 0 ? "%.2f" : "%.0f";
+
             for (int i = kParamPot1; i <= kParamPot6; ++i)
             {
-                name = "Pot " + String(i + 1) + " (CC " + String(20 + i) + ")";
-
-                if (ImGui::SliderInt(name, params + i, 0, 127))
+                if (ImGui::SliderFloat(kBindingLabels.names[i], hiResParams + i, 0.0f, 127.0f, hiResFormat))
                 {
                     if (ImGui::IsItemActivated())
                         editParameter(i, true);
 
-                    setParameterValue(i, params[i]);
+                    setParameterValue(i, hiResParams[i]);
                 }
 
                 if (ImGui::IsItemDeactivated())
@@ -178,9 +623,7 @@ protected:
 
             for (int i = kParamFoot1; i <= kParamFoot3; ++i)
             {
-                name = "Foot " + String(i - kParamFoot1 + 1) + " (CC " + String(17 + i - kParamFoot1) + ")";
-
-                if (ImGui::SliderInt(name, params + i, 0, 1))
+                if (ImGui::SliderInt(kBindingLabels.names[i], params + i, 0, 1))
                 {
                     if (ImGui::IsItemActivated())
                         editParameter(i, true);
@@ -193,12 +636,12 @@ protected:
             }
 
             {
-                if (ImGui::SliderInt("Exp.Pedal (CC 89)", params + kParamExpPedal, 0, 127))
+                if (ImGui::SliderFloat(kBindingLabels.names[kParamExpPedal], hiResParams + kParamExpPedal, 0.0f, 127.0f, hiResFormat))
                 {
                     if (ImGui::IsItemActivated())
                         editParameter(kParamExpPedal, true);
 
-                    setParameterValue(kParamExpPedal, params[kParamExpPedal]);
+                    setParameterValue(kParamExpPedal, hiResParams[kParamExpPedal]);
                 }
 
                 if (ImGui::IsItemDeactivated())
@@ -211,23 +654,227 @@ protected:
         ImGui::SetNextWindowSize(ImVec2(width2, height));
         if (ImGui::Begin("Flexible", nullptr, ImGuiWindowFlags_AlwaysVerticalScrollbar | ImGuiWindowFlags_NoDecoration))
         {
-            ImGui::SeparatorText("Generic CCs");
+            ImGui::SeparatorText("Output");
+
+            {
+                if (ImGui::SliderFloat("Event spacing (ms)", &eventSpacing, 0.0f, 10.0f, "%.2f"))
+                {
+                    if (ImGui::IsItemActivated())
+                        editParameter(kParamEventSpacing, true);
+
+                    setParameterValue(kParamEventSpacing, eventSpacing);
+                }
+
+                if (ImGui::IsItemDeactivated())
+                    editParameter(kParamEventSpacing, false);
+            }
+
+            if (ImGui::InputInt("Link rate (baud)", &linkRate, 0, 0))
+            {
+                linkRate = std::clamp(linkRate, 0, 1000000);
+                setParameterValue(kParamLinkRate, linkRate);
+            }
+
+            if (ImGui::Checkbox("Running status", &runningStatus))
+                setParameterValue(kParamRunningStatus, runningStatus ? 1.0f : 0.0f);
+
+            if (ImGui::Combo("High resolution", &hiResMode, kHiResModeNames, ARRAY_SIZE(kHiResModeNames)))
+                setParameterValue(kParamHiResMode, hiResMode);
+
+            {
+                if (ImGui::SliderFloat("Smoothing (ms)", &smoothing, 0.0f, 1000.0f, "%.0f"))
+                {
+                    if (ImGui::IsItemActivated())
+                        editParameter(kParamSmoothing, true);
+
+                    setParameterValue(kParamSmoothing, smoothing);
+                }
+
+                if (ImGui::IsItemDeactivated())
+                    editParameter(kParamSmoothing, false);
+            }
+
+            if (ImGui::InputFloat("Resync every (s)", &resyncInterval, 0.0f, 0.0f, "%.1f"))
+            {
+                resyncInterval = std::clamp(resyncInterval, 0.0f, 3600.0f);
+                setParameterValue(kParamResyncInterval, resyncInterval);
+            }
+            ImGui::SameLine();
+            if (ImGui::Button("Resync now"))
+                setState("resync", "");
+
+            if (ImGui::Checkbox("Resend on activate", &resendOnActivate))
+                setParameterValue(kParamResendOnActivate, resendOnActivate ? 1.0f : 0.0f);
 
-            for (uint8_t i = 0; i < std::size(kAllowedCCs); ++i)
+            ImGui::Text("Action latency: %.2f ms (max)", actionLatency);
+
+            ImGui::SeparatorText("MIDI Thru");
+
+            if (ImGui::Checkbox("Enabled##thru", &thru))
+                setParameterValue(kParamThru, thru ? 1.0f : 0.0f);
+
+            ImGui::SameLine();
+
+            if (ImGui::Checkbox("Our CCs override thru", &thruOverride))
+                setParameterValue(kParamThruOverride, thruOverride ? 1.0f : 0.0f);
+
+            if (ImGui::SliderInt("Channel (0 = all)##thru", &thruChannel, 0, 16))
+                setParameterValue(kParamThruChannel, thruChannel);
+
+            if (ImGui::SliderInt("First CC##thru", &thruFirstCC, 0, 127))
+                setParameterValue(kParamThruFirstCC, thruFirstCC);
+
+            if (ImGui::SliderInt("Last CC##thru", &thruLastCC, 0, 127))
+                setParameterValue(kParamThruLastCC, thruLastCC);
+
+            ImGui::SeparatorText("Device Feedback");
+            ImGui::Text("Bank %d, Preset %d, Scene %d, Mode %d", deviceBank, devicePreset, deviceScene, deviceMode + 1);
+
+            ImGui::SeparatorText("Timeline");
+
+            if (ImGui::Button("Record##timeline"))
+                setState("timeline", "record");
+            ImGui::SameLine();
+            if (ImGui::Button("Play##timeline"))
+                setState("timeline", "play");
+            ImGui::SameLine();
+            if (ImGui::Button("Stop##timeline"))
+                setState("timeline", "stop");
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Follow host transport", &timelineSync))
+                setParameterValue(kParamTimelineSync, timelineSync ? 1.0f : 0.0f);
+
+            ImGui::Text("%s, event %d of %d", kTimelineStateNames[timelineState], timelinePosition, timelineEvents);
+
+            ImGui::InputText("File##timeline", timelinePath, sizeof(timelinePath));
+            if (ImGui::Button("Save##timeline") && timelinePath[0] != '\0')
+                setState("timeline_save", timelinePath);
+            ImGui::SameLine();
+            if (ImGui::Button("Load##timeline") && timelinePath[0] != '\0')
+                setState("timeline_load", timelinePath);
+
+            ImGui::SeparatorText("Script");
+
+            ImGui::InputText("File##script", scriptPath, sizeof(scriptPath));
+            if (ImGui::Button("Load##script") && scriptPath[0] != '\0')
+                setState("script_load", scriptPath);
+            ImGui::SameLine();
+            if (ImGui::Button("Play##script"))
+                setState("script", "play");
+            ImGui::SameLine();
+            if (ImGui::Button("Stop##script"))
+                setState("script", "stop");
+
+            ImGui::Text("%s, event %d of %d", scriptPlaying ? "Playing" : "Stopped", scriptPosition, scriptEvents);
+
+            ImVec2 panelStart = ImGui::GetCursorScreenPos();
+            ImGui::SeparatorText("Stress Test");
+
+            if (ImGui::Combo("Mode##stress", &stressMode, kStressModeNames, ARRAY_SIZE(kStressModeNames)))
+                setParameterValue(kParamStressMode, stressMode);
+
+            if (ImGui::InputInt("Rate (msg/s)##stress", &stressRate, 0, 0))
+            {
+                stressRate = std::clamp(stressRate, 1, 10000);
+                setParameterValue(kParamStressRate, stressRate);
+            }
+
+            if (ImGui::InputInt("Seed##stress", &stressSeed, 0, 0))
             {
-                name = "CC " + String(kAllowedCCs[i]);
+                stressSeed = std::clamp(stressSeed, 0, 65535);
+                setParameterValue(kParamStressSeed, stressSeed);
+            }
 
-                if (ImGui::SliderInt(name, params + (kParamCCs + i), 0, 127))
+            ImGui::Text("Achieved %.0f of %d msg/s, missed %.0f msg/s", stressAchievedRate, stressRate, stressMissedRate);
+            updatePanelVisibility(kPanelStress, panelStart);
+
+            panelStart = ImGui::GetCursorScreenPos();
+            ImGui::SeparatorText("Latency Probe");
+
+            if (ImGui::Combo("Mode##probe", &probeMode, kProbeModeNames, ARRAY_SIZE(kProbeModeNames)))
+                setParameterValue(kParamProbeMode, probeMode);
+
+            {
+                if (ImGui::SliderFloat("Interval (ms)##probe", &probeInterval, 50.0f, 5000.0f, "%.0f"))
                 {
                     if (ImGui::IsItemActivated())
-                        editParameter(kParamCCs + i, true);
+                        editParameter(kParamProbeInterval, true);
 
-                    setParameterValue(kParamCCs + i, params[kParamCCs + i]);
+                    setParameterValue(kParamProbeInterval, probeInterval);
                 }
 
                 if (ImGui::IsItemDeactivated())
-                    editParameter(kParamCCs + i, false);
+                    editParameter(kParamProbeInterval, false);
+            }
+
+            ImGui::Text("Last %d samples (%.2f ms), %d answered, %d lost",
+                        probeLastLatency, probeLastLatency * 1000.0 / getSampleRate(), probeCount, probeLost);
+            ImGui::Text("Min %.2f ms, median %.2f ms, p99 %.2f ms", probeMin / 1000.0f, probeMedian / 1000.0f, probeP99 / 1000.0f);
+            ImGui::PlotHistogram("0-100 ms##probe", probeHistogram, kProbeHistogramBins, 0, nullptr, 0.0f, FLT_MAX,
+                                 ImVec2(0, 60 * scaleFactor));
+            updatePanelVisibility(kPanelProbe, panelStart);
+
+            panelStart = ImGui::GetCursorScreenPos();
+            ImGui::SeparatorText("Statistics");
+
+            ImGui::Text("Events/s: %.0f emitted, %.0f deferred, %.0f rejected, %.0f dropped",
+                        stats[kParamStatsEmitted - kParamStatsEmitted],
+                        stats[kParamStatsDeferred - kParamStatsEmitted],
+                        stats[kParamStatsRejected - kParamStatsEmitted],
+                        stats[kParamStatsDropped - kParamStatsEmitted]);
+            ImGui::Text("Pending: %.0f (max), commands lost: %.0f",
+                        stats[kParamStatsPending - kParamStatsEmitted],
+                        stats[kParamStatsOverflows - kParamStatsEmitted]);
+            ImGui::Text("Run time: %.1f / %.1f / %.1f us (min / avg / max)",
+                        stats[kParamStatsRunMin - kParamStatsEmitted],
+                        stats[kParamStatsRunAvg - kParamStatsEmitted],
+                        stats[kParamStatsRunMax - kParamStatsEmitted]);
+            updatePanelVisibility(kPanelStats, panelStart);
+
+            ImGui::SeparatorText("Generic CCs");
+
+            ImGui::SetNextItemWidth(80 * scaleFactor);
+            if (ImGui::InputText("Filter##cc", ccFilter, sizeof(ccFilter)))
+                ccRowsDirty = true;
+            ImGui::SameLine();
+            if (ImGui::Checkbox("Recently changed##cc", &ccRecentOnly))
+                ccRowsDirty = true;
+
+            if (ccRowsDirty)
+                updateCCRows();
+
+            // only visible rows are laid out and drawn, so frames cost the same regardless of the number of CCs
+            if (ImGui::BeginChild("##ccs", ImVec2(0, 320 * scaleFactor)))
+            {
+                ImGuiListClipper clipper;
+                clipper.Begin(ccRowCount);
+
+                while (clipper.Step())
+                {
+                    for (int row = clipper.DisplayStart; row < clipper.DisplayEnd; ++row)
+                    {
+                        const uint i = kParamCCs + ccRows[row];
+
+                        if (ImGui::SliderInt(kBindingLabels.names[i], params + i, 0, 127))
+                        {
+                            if (ImGui::IsItemActivated())
+                                editParameter(i, true);
+
+                            setParameterValue(i, params[i]);
+                        }
+
+                        // not while dragging, as it could move the row being edited
+                        if (ImGui::IsItemDeactivated())
+                        {
+                            editParameter(i, false);
+                            addRecentCC(ccRows[row]);
+                        }
+                    }
+                }
+
+                clipper.End();
             }
+            ImGui::EndChild();
         }
         ImGui::End();
     }
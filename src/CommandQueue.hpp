@@ -0,0 +1,380 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+#include "KeyDispatch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+enum CommandType : uint16_t {
+    kCommandAction,
+    kCommandParameter,
+    kCommandHiResParameter, // value is 14-bit, only for bindings that support it
+    kCommandTimeline,
+    kCommandScript,
+    kCommandResync,
+    kCommandBatch, // value is the number of commands that follow, which must all be dequeued together
+    kCommandSnapshot, // index is the operation, value the snapshot number (two of them for a morph, second one << 8)
+};
+
+// command index for kCommandAction
+enum Actions {
+    kActionBank,
+    kActionPreset,
+    kActionScene,
+    kActionMode,
+    kActionTuner,
+    kActionCount
+};
+
+// state and script keys of each action, in the same order as above
+static constexpr const char* const kActionNames[] = {
+    "bank",
+    "preset",
+    "scene",
+    "mode",
+    "tuner",
+};
+static_assert(std::size(kActionNames) == kActionCount, "wrong number of action names");
+
+static constexpr const KeyDispatch<kActionCount> kActionKeys(kActionNames);
+static_assert(kActionKeys.isValid(), "no perfect hash for action names");
+
+// special action values for relative bank/preset/scene changes
+enum ActionSteps {
+    kActionStepNext = -1,
+    kActionStepPrevious = -2,
+};
+
+/**
+   A single command sent from the control side (host, UI) into the realtime side.
+   Kept small and trivial so it can be passed around by value, and so that arrays of it are left uninitialized.
+   The MIDI channel selects which unit the command is for, it is ignored for commands that are not sent to a device.
+   Brace-initialized commands that leave out the channel get channel 0.
+ */
+struct Command {
+    uint16_t type;
+    uint16_t index;
+    int32_t value;
+    uint8_t channel;
+};
+static_assert(std::is_trivial<Command>::value, "commands must be trivial");
+
+/**
+   Parse an action given as a key and value, as sent through plugin state or written in command scripts.
+   Returns false if the key is not an action or its value is invalid, the channel is left for the caller to set.
+ */
+static inline bool parseAction(const char* const key, const char* const value, Command& command) noexcept
+{
+    const uint32_t action = kActionKeys.lookup(key);
+
+    if (action == kActionKeys.kNotFound)
+        return false;
+
+    command.type = kCommandAction;
+    command.index = action;
+    command.value = 0;
+
+    switch (command.index)
+    {
+    case kActionBank:
+    case kActionPreset:
+        switch (value[0])
+        {
+        case '+':
+            command.value = kActionStepNext;
+            break;
+        case '-':
+            command.value = kActionStepPrevious;
+            break;
+        default:
+            {
+                // an empty value or a typo must not silently select the first one
+                char* end;
+                command.value = std::strtol(value, &end, 10);
+
+                if (end == value || *end != '\0')
+                    return false;
+            }
+            break;
+        }
+        break;
+    case kActionScene:
+        switch (value[0])
+        {
+        case '0' ... '3':
+            command.value = value[0] - '0';
+            break;
+        case '+':
+            command.value = kActionStepNext;
+            break;
+        case '-':
+            command.value = kActionStepPrevious;
+            break;
+        default:
+            return false;
+        }
+        break;
+    case kActionMode:
+        if (value[0] == '\0')
+            return false;
+        command.value = std::clamp(value[0] - '1', 0, 2);
+        break;
+    }
+
+    return true;
+}
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Bounded multi-producer, single-consumer queue.
+
+   Producers may call push() from any number of threads at the same time, it never blocks nor allocates.
+   The consumer side (pop, peek, clear) must only ever be used by a single thread, typically the audio one.
+
+   When the queue is full push() fails and the overflow counter is incremented,
+   so callers can decide what to do with the dropped data and its loss is never silent.
+
+   Implementation is the classic bounded queue with per-slot sequence numbers,
+   a slot is only readable once its sequence matches the read position.
+ */
+template <class T, uint32_t kSize>
+class CommandQueue
+{
+    static_assert(kSize != 0 && (kSize & (kSize - 1)) == 0, "queue size must be a power of 2");
+
+    struct Slot {
+        std::atomic<uint32_t> sequence;
+        T data;
+    };
+
+    alignas(64) std::atomic<uint32_t> writePos { 0 };
+    alignas(64) std::atomic<uint32_t> overflowCount { 0 };
+    alignas(64) uint32_t readPos = 0;
+    Slot slots[kSize];
+
+public:
+    CommandQueue() noexcept
+    {
+        for (uint32_t i = 0; i < kSize; ++i)
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // producer side, any thread
+
+    bool push(const T& data) noexcept
+    {
+        uint32_t pos = writePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            Slot& slot = slots[pos & (kSize - 1)];
+            const int32_t diff = static_cast<int32_t>(slot.sequence.load(std::memory_order_acquire) - pos);
+
+            if (diff == 0)
+            {
+                if (writePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                {
+                    slot.data = data;
+                    slot.sequence.store(pos + 1, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                overflowCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = writePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+   /**
+      Push @a count items into consecutive slots, so that they are never interleaved with items from other producers.
+      Either all items are pushed or none, in which case the overflow counter is incremented once.
+    */
+    bool pushBatch(const T* const data, const uint32_t count) noexcept
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(count != 0 && count <= kSize, false);
+
+        uint32_t pos = writePos.load(std::memory_order_relaxed);
+
+        for (;;)
+        {
+            const int32_t diff = static_cast<int32_t>(slots[pos & (kSize - 1)].sequence.load(std::memory_order_acquire) - pos);
+
+            if (diff == 0)
+            {
+                // slots are freed in order, so the last one being free means all others are too
+                const uint32_t last = pos + count - 1;
+
+                if (slots[last & (kSize - 1)].sequence.load(std::memory_order_acquire) != last)
+                {
+                    overflowCount.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                if (writePos.compare_exchange_weak(pos, pos + count, std::memory_order_relaxed))
+                {
+                    for (uint32_t i = 0; i < count; ++i)
+                    {
+                        Slot& slot = slots[(pos + i) & (kSize - 1)];
+                        slot.data = data[i];
+                        slot.sequence.store(pos + i + 1, std::memory_order_release);
+                    }
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                overflowCount.fetch_add(1, std::memory_order_relaxed);
+                return false;
+            }
+            else
+            {
+                pos = writePos.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    uint32_t getOverflowCount() const noexcept
+    {
+        return overflowCount.load(std::memory_order_relaxed);
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // consumer side, single thread only
+
+   /**
+      Check if the next @a count items can be read, for batches pushed with pushBatch().
+    */
+    bool isReadable(const uint32_t count) const noexcept
+    {
+        if (count > kSize)
+            return false;
+
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            if (slots[(readPos + i) & (kSize - 1)].sequence.load(std::memory_order_acquire) != readPos + i + 1)
+                return false;
+        }
+
+        return true;
+    }
+
+    const T* peek() const noexcept
+    {
+        const Slot& slot = slots[readPos & (kSize - 1)];
+
+        if (slot.sequence.load(std::memory_order_acquire) != readPos + 1)
+            return nullptr;
+
+        return &slot.data;
+    }
+
+    // must only be called after a successful peek()
+    void skip() noexcept
+    {
+        slots[readPos & (kSize - 1)].sequence.store(readPos + kSize, std::memory_order_release);
+        ++readPos;
+    }
+
+    void clear() noexcept
+    {
+        while (peek() != nullptr)
+            skip();
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(CommandQueue)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Fixed-size FIFO for use within a single thread, no locking or atomics involved.
+   Used on the realtime side to hold commands that were already taken from a CommandQueue but not yet processed.
+ */
+template <class T, uint32_t kSize>
+class CommandFifo
+{
+    static_assert(kSize != 0 && (kSize & (kSize - 1)) == 0, "fifo size must be a power of 2");
+
+    T items[kSize];
+    uint32_t head = 0;
+    uint32_t count = 0;
+
+public:
+    CommandFifo() noexcept = default;
+
+    bool isEmpty() const noexcept
+    {
+        return count == 0;
+    }
+
+    bool isFull() const noexcept
+    {
+        return count == kSize;
+    }
+
+    uint32_t getCount() const noexcept
+    {
+        return count;
+    }
+
+    uint32_t getFreeCount() const noexcept
+    {
+        return kSize - count;
+    }
+
+    bool push(const T& item) noexcept
+    {
+        if (count == kSize)
+            return false;
+
+        items[(head + count++) & (kSize - 1)] = item;
+        return true;
+    }
+
+    // must only be called when not empty
+    const T& front() const noexcept
+    {
+        return items[head];
+    }
+
+    // must only be called when not empty
+    void pop() noexcept
+    {
+        head = (head + 1) & (kSize - 1);
+        --count;
+    }
+
+    void clear() noexcept
+    {
+        head = count = 0;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(CommandFifo)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,414 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoPlugin.hpp"
+#include "CommandQueue.hpp"
+
+#include <cstdio>
+#include <sys/stat.h>
+
+#ifdef _WIN32
+# include <windows.h>
+#else
+# include <fcntl.h>
+# include <sys/mman.h>
+# include <unistd.h>
+#endif
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Precompiled command script, memory-mapped for playback.
+
+   Scripts are written as text, one command per line, with the same keys and values as the plugin state:
+   @code
+   # comments start with '#'
+   bank 3
+   preset +
+   scene 2
+   mode 1
+   tuner
+   cc 33 100
+   wait 10ms
+   channel 2
+   scene +
+   @endcode
+   Waits take a "us", "ms" or "s" unit and delay all commands after them, waits in a row add up.
+   A wait at the end of the script is kept as a no-op command, so playback only finishes once it has elapsed.
+   Commands go to the unit on MIDI channel 1 unless a "channel" line selects another one, for all commands after it.
+
+   Text is compiled once into a binary file of fixed-size events, which is mapped as-is into memory,
+   so that loading is instant regardless of the script size and playback needs no parsing.
+   The binary file uses native byte order, it is not meant to be shared between machines.
+ */
+class CommandScript
+{
+public:
+    struct Event {
+        uint32_t delay; // in microseconds, since the previous event
+        Command command;
+    };
+    static_assert(sizeof(Event) == 16, "script events must be tightly packed");
+
+    ~CommandScript()
+    {
+       #ifdef _WIN32
+        UnmapViewOfFile(data);
+       #else
+        munmap(data, size);
+       #endif
+    }
+
+    uint32_t getCount() const noexcept
+    {
+        return count;
+    }
+
+    const Event& getEvent(const uint32_t index) const noexcept
+    {
+        return events[index];
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // non-realtime
+
+   /**
+      Compile the text script @a textFile into @a binaryFile.
+      Errors are printed along with their line number, nothing is written to @a binaryFile in such case.
+    */
+    static bool compile(const char* const textFile, const char* const binaryFile)
+    {
+        FILE* const in = std::fopen(textFile, "r");
+        DISTRHO_SAFE_ASSERT_RETURN(in != nullptr, false);
+
+        FILE* const out = std::fopen(binaryFile, "wb");
+        if (out == nullptr)
+        {
+            std::fclose(in);
+            d_stderr2("CommandScript: failed to open %s for writing", binaryFile);
+            return false;
+        }
+
+        Header header = {};
+        std::memcpy(header.magic, kMagic, sizeof(kMagic));
+        header.version = kVersion;
+        std::fwrite(&header, sizeof(header), 1, out);
+
+        char line[256];
+        uint32_t lineNumber = 0;
+        uint64_t delay = 0;
+        uint8_t channel = 0;
+        bool ok = true;
+
+        while (ok && std::fgets(line, sizeof(line), in) != nullptr)
+        {
+            ++lineNumber;
+
+            Command command;
+            switch (parseLine(line, delay, channel, command))
+            {
+            case kLineEmpty:
+                continue;
+            case kLineInvalid:
+                d_stderr2("CommandScript: %s:%u: invalid command", textFile, lineNumber);
+                ok = false;
+                continue;
+            case kLineCommand:
+                break;
+            }
+
+            command.channel = channel;
+            ok = writeEvent(out, header, delay, command);
+        }
+
+        std::fclose(in);
+
+        // trailing waits are kept as a final no-op
+        if (ok && delay != 0)
+            ok = writeEvent(out, header, delay, { kCommandScript, 0, 0, 0 });
+
+        if (ok)
+        {
+            std::fseek(out, 0, SEEK_SET);
+            std::fwrite(&header, sizeof(header), 1, out);
+            ok = std::ferror(out) == 0;
+        }
+
+        if (std::fclose(out) != 0)
+            ok = false;
+
+        if (! ok)
+            std::remove(binaryFile);
+
+        return ok;
+    }
+
+   /**
+      Map a script previously compiled with compile(), returns nullptr on failure.
+      All pages are touched here so that playback does not trigger disk reads.
+    */
+    static CommandScript* open(const char* const binaryFile)
+    {
+        void* data;
+        size_t size;
+
+       #ifdef _WIN32
+        const HANDLE file = CreateFileA(binaryFile, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+        DISTRHO_SAFE_ASSERT_RETURN(file != INVALID_HANDLE_VALUE, nullptr);
+
+        LARGE_INTEGER fileSize;
+        const HANDLE mapping = GetFileSizeEx(file, &fileSize)
+                             ? CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr)
+                             : nullptr;
+        CloseHandle(file);
+        DISTRHO_SAFE_ASSERT_RETURN(mapping != nullptr, nullptr);
+
+        data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        DISTRHO_SAFE_ASSERT_RETURN(data != nullptr, nullptr);
+
+        size = static_cast<size_t>(fileSize.QuadPart);
+       #else
+        const int fd = ::open(binaryFile, O_RDONLY);
+        DISTRHO_SAFE_ASSERT_RETURN(fd >= 0, nullptr);
+
+        struct stat st;
+        if (fstat(fd, &st) != 0 || st.st_size < static_cast<off_t>(sizeof(Header)))
+        {
+            close(fd);
+            return nullptr;
+        }
+
+        size = static_cast<size_t>(st.st_size);
+        data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        close(fd);
+        DISTRHO_SAFE_ASSERT_RETURN(data != MAP_FAILED, nullptr);
+
+        madvise(data, size, MADV_WILLNEED);
+       #endif
+
+        CommandScript* const script = new CommandScript(data, size);
+
+        if (! script->isValid())
+        {
+            d_stderr2("CommandScript: %s is not a valid compiled script", binaryFile);
+            delete script;
+            return nullptr;
+        }
+
+        script->prefault();
+        return script;
+    }
+
+   /**
+      Load a script, compiling it first if needed.
+      Text scripts are compiled next to the original file, and only when changed since the last compilation.
+    */
+    static CommandScript* load(const char* const filename)
+    {
+        const size_t len = std::strlen(filename);
+
+        if (len > 5 && std::strcmp(filename + len - 5, ".amcs") == 0)
+            return open(filename);
+
+        String binaryFile(filename);
+        binaryFile += ".amcs";
+
+        if (! isOutdated(filename, binaryFile))
+        {
+            if (CommandScript* const script = open(binaryFile))
+                return script;
+        }
+
+        // also recompiles files from older versions
+        if (! compile(filename, binaryFile))
+            return nullptr;
+
+        return open(binaryFile);
+    }
+
+private:
+    struct Header {
+        char magic[4];
+        uint32_t version;
+        uint32_t count;
+        uint32_t reserved;
+    };
+
+    enum LineType {
+        kLineEmpty,
+        kLineInvalid,
+        kLineCommand,
+    };
+
+    static constexpr const char kMagic[4] = { 'A', 'M', 'C', 'S' };
+    static constexpr const uint32_t kVersion = 2;
+
+    void* const data;
+    const size_t size;
+    const Event* events = nullptr;
+    uint32_t count = 0;
+
+    CommandScript(void* const data_, const size_t size_) noexcept
+        : data(data_),
+          size(size_) {}
+
+    bool isValid() noexcept
+    {
+        if (size < sizeof(Header))
+            return false;
+
+        const Header* const header = static_cast<const Header*>(data);
+
+        if (std::memcmp(header->magic, kMagic, sizeof(kMagic)) != 0 || header->version != kVersion)
+            return false;
+        if (header->count > (size - sizeof(Header)) / sizeof(Event))
+            return false;
+
+        events = reinterpret_cast<const Event*>(static_cast<const uint8_t*>(data) + sizeof(Header));
+        count = header->count;
+        return true;
+    }
+
+    void prefault() const noexcept
+    {
+        // volatile reads are never optimized out
+        const volatile uint8_t* const bytes = static_cast<const uint8_t*>(data);
+
+        for (size_t i = 0; i < size; i += 4096)
+            static_cast<void>(bytes[i]);
+    }
+
+   /**
+      Write a single event after @a delay microseconds, which is consumed.
+      Events are zeroed first so that no uninitialized padding ends up in the file.
+      Returns false once the script is full.
+    */
+    static bool writeEvent(FILE* const out, Header& header, uint64_t& delay, const Command& command)
+    {
+        Event event;
+
+        // waits longer than our delay type can hold are split with no-op commands
+        while (delay > UINT32_MAX)
+        {
+            std::memset(&event, 0, sizeof(event));
+            event.delay = UINT32_MAX;
+            event.command.type = kCommandScript;
+            std::fwrite(&event, sizeof(event), 1, out);
+            delay -= UINT32_MAX;
+
+            if (++header.count == UINT32_MAX)
+                return false;
+        }
+
+        std::memset(&event, 0, sizeof(event));
+        event.delay = static_cast<uint32_t>(delay);
+        event.command.type = command.type;
+        event.command.index = command.index;
+        event.command.value = command.value;
+        event.command.channel = command.channel;
+        std::fwrite(&event, sizeof(event), 1, out);
+        delay = 0;
+
+        return ++header.count != UINT32_MAX;
+    }
+
+    static bool isOutdated(const char* const textFile, const char* const binaryFile)
+    {
+        struct stat textStat, binaryStat;
+
+        if (stat(binaryFile, &binaryStat) != 0)
+            return true;
+        if (stat(textFile, &textStat) != 0)
+            return false;
+
+        return textStat.st_mtime >= binaryStat.st_mtime;
+    }
+
+   /**
+      Parse a single line, accumulating waits into @a delay and keeping the last selected channel in @a channel.
+    */
+    static LineType parseLine(char* const line, uint64_t& delay, uint8_t& channel, Command& command)
+    {
+        if (char* const comment = std::strchr(line, '#'))
+            *comment = '\0';
+
+        char key[16], arg1[16], arg2[16];
+        const int args = std::sscanf(line, "%15s %15s %15s", key, arg1, arg2);
+
+        if (args <= 0)
+            return kLineEmpty;
+
+        if (std::strcmp(key, "wait") == 0)
+        {
+            if (args < 2)
+                return kLineInvalid;
+
+            // the unit can be attached to the value or come separately
+            const char* unit;
+            const double value = std::strtod(arg1, const_cast<char**>(&unit));
+
+            if (unit == arg1 || value < 0.0)
+                return kLineInvalid;
+            if (*unit == '\0')
+                unit = args == 3 ? arg2 : "";
+            else if (args == 3)
+                return kLineInvalid;
+
+            /**/ if (std::strcmp(unit, "us") == 0)
+                delay += static_cast<uint64_t>(value + 0.5);
+            else if (std::strcmp(unit, "ms") == 0)
+                delay += static_cast<uint64_t>(value * 1000.0 + 0.5);
+            else if (std::strcmp(unit, "s") == 0)
+                delay += static_cast<uint64_t>(value * 1000000.0 + 0.5);
+            else
+                return kLineInvalid;
+
+            return kLineEmpty;
+        }
+
+        if (std::strcmp(key, "channel") == 0)
+        {
+            if (args != 2)
+                return kLineInvalid;
+
+            const int value = std::atoi(arg1);
+
+            if (value < 1 || value > 16)
+                return kLineInvalid;
+
+            channel = static_cast<uint8_t>(value - 1);
+            return kLineEmpty;
+        }
+
+        if (std::strcmp(key, "cc") == 0)
+        {
+            if (args != 3)
+                return kLineInvalid;
+
+            const int cc = std::atoi(arg1);
+            const int value = std::atoi(arg2);
+
+            if (cc < 0 || cc > 127 || value < 0 || value > 127 || kCCToParam[cc] == kCCUnbound)
+                return kLineInvalid;
+
+            command = { kCommandParameter, kCCToParam[cc], value, 0 };
+            return kLineCommand;
+        }
+
+        return parseAction(key, args >= 2 ? arg1 : "", command) ? kLineCommand : kLineInvalid;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(CommandScript)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
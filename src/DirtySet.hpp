@@ -0,0 +1,108 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Packed set of dirty flags, one bit per index.
+
+   Visiting only looks at the bits that are set, by jumping between them with count-trailing-zeros,
+   so the cost of an idle set is a single test per 64 indexes regardless of how many are tracked.
+ */
+template <uint32_t kCount>
+class DirtySet
+{
+    static constexpr const uint32_t kWordCount = (kCount + 63) / 64;
+
+    uint64_t words[kWordCount] = {};
+
+public:
+    DirtySet() noexcept = default;
+
+    void set(const uint32_t index) noexcept
+    {
+        words[index / 64] |= 1ULL << (index % 64);
+    }
+
+    void reset(const uint32_t index) noexcept
+    {
+        words[index / 64] &= ~(1ULL << (index % 64));
+    }
+
+    bool test(const uint32_t index) const noexcept
+    {
+        return (words[index / 64] >> (index % 64)) & 1;
+    }
+
+    bool isEmpty() const noexcept
+    {
+        uint64_t any = 0;
+        for (uint32_t w = 0; w < kWordCount; ++w)
+            any |= words[w];
+        return any == 0;
+    }
+
+    uint32_t getCount() const noexcept
+    {
+        uint32_t count = 0;
+        for (uint32_t w = 0; w < kWordCount; ++w)
+            count += __builtin_popcountll(words[w]);
+        return count;
+    }
+
+    void clear() noexcept
+    {
+        for (uint32_t w = 0; w < kWordCount; ++w)
+            words[w] = 0;
+    }
+
+   /**
+      Visit set indexes within [@a first, @a last) in ascending order, without clearing them.
+      The callback may set or reset any index, only indexes set when reaching their 64-bit word are visited.
+      It returns false to stop early, in which case this returns false too.
+    */
+    template <class Callback>
+    bool visit(const uint32_t first, const uint32_t last, Callback&& callback)
+    {
+        if (first >= last)
+            return true;
+
+        for (uint32_t w = first / 64, lastWord = (last - 1) / 64; w <= lastWord; ++w)
+        {
+            for (uint64_t bits = words[w] & getMask(w, first, last); bits != 0; bits &= bits - 1)
+            {
+                if (! callback(w * 64 + __builtin_ctzll(bits)))
+                    return false;
+            }
+        }
+
+        return true;
+    }
+
+private:
+    // bits of word @a w within [@a first, @a last)
+    static uint64_t getMask(const uint32_t w, const uint32_t first, const uint32_t last) noexcept
+    {
+        uint64_t mask = ~0ULL;
+
+        if (w == first / 64)
+            mask &= ~0ULL << (first % 64);
+        if (w == (last - 1) / 64 && (last % 64) != 0)
+            mask &= ~0ULL >> (64 - last % 64);
+
+        return mask;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -5,6 +5,7 @@
  */
 
 #include <cstdint>
+#include <iterator>
 
 /**
    The plugin name.@n
@@ -83,7 +84,7 @@
    so Plugin::canRequestParameterValueChanges() can be used to query support at runtime.
    @see Plugin::requestParameterValueChange(uint32_t, float)
  */
-#define DISTRHO_PLUGIN_WANT_PARAMETER_VALUE_CHANGE_REQUEST 0
+#define DISTRHO_PLUGIN_WANT_PARAMETER_VALUE_CHANGE_REQUEST 1
 
 /**
    Whether the plugin provides its own internal programs.
@@ -107,13 +108,13 @@
    @note this macro is automatically enabled if a plugin has programs and state, as the key-value state pairs need to be updated when the current program changes.
    @see Plugin::getState(const char*)
  */
-#define DISTRHO_PLUGIN_WANT_FULL_STATE 0
+#define DISTRHO_PLUGIN_WANT_FULL_STATE 1
 
 /**
    Whether the plugin wants time position information from the host.
    @see Plugin::getTimePosition()
  */
-#define DISTRHO_PLUGIN_WANT_TIMEPOS 0
+#define DISTRHO_PLUGIN_WANT_TIMEPOS 1
 
 /**
    Whether the %UI uses a custom toolkit implementation based on OpenGL.@n
@@ -366,6 +367,10 @@ static constexpr const uint8_t kAllowedCCs[] = {
     120, 121, 122, 123, 124, 125, 126, 127,
 };
 
+// latency probe histogram, as published to the UI
+static constexpr const uint32_t kProbeHistogramBins = 20;
+static constexpr const uint32_t kProbeHistogramBinWidth = 5000; // in microseconds, up to 100ms
+
 enum Parameters {
    // Pots
    kParamPot1,
@@ -376,6 +381,137 @@ enum Parameters {
    // Other
    kParamExpPedal,
    kParamCCs,
+   // Total of parameters sent as MIDI
+   kParamBindingCount = kParamCCs + std::size(kAllowedCCs),
+   // Settings
+   kParamEventSpacing = kParamBindingCount,
+   kParamLinkRate,
+   kParamRunningStatus,
+   kParamHiResMode,
+   kParamSmoothing,
+   kParamMorphTime,
+   kParamResyncInterval,
+   kParamResendOnActivate,
+   kParamUnitCount,
+   kParamUnit,
+   kParamOutputRouting,
+   kParamThru,
+   kParamThruChannel,
+   kParamThruFirstCC,
+   kParamThruLastCC,
+   kParamThruOverride,
+   kParamTimelineSync,
+   kParamStressMode,
+   kParamStressRate,
+   kParamStressSeed,
+   kParamProbeMode,
+   kParamProbeInterval,
+   // Outputs
+   kParamActionLatency,
+   kParamDeviceBank,
+   kParamDevicePreset,
+   kParamDeviceScene,
+   kParamDeviceMode,
+   kParamTimelineState,
+   kParamTimelineEvents,
+   kParamTimelinePosition,
+   kParamScriptState,
+   kParamScriptEvents,
+   kParamScriptPosition,
+   kParamStressAchievedRate,
+   kParamStressMissedRate,
+   kParamProbeLastLatency,
+   kParamProbeMin,
+   kParamProbeMedian,
+   kParamProbeP99,
+   kParamProbeCount,
+   kParamProbeLost,
+   kParamProbeHistogram,
+   kParamProbeHistogramLast = kParamProbeHistogram + kProbeHistogramBins - 1,
+   kParamStatsEmitted,
+   kParamStatsDeferred,
+   kParamStatsRejected,
+   kParamStatsDropped,
+   kParamStatsPending,
+   kParamStatsOverflows,
+   kParamStatsRunMin,
+   kParamStatsRunAvg,
+   kParamStatsRunMax,
    // Total
-   kParamCount = kParamCCs + std::size(kAllowedCCs),
+   kParamCount
+};
+
+// units are addressed by MIDI channel, each one with its own set of bindings
+static constexpr const uint32_t kMaxUnits = 16;
+
+// snapshots of all bindings of a unit, for recalling and morphing between them
+static constexpr const uint32_t kSnapshotCount = 16;
+
+// fixed CC bindings, the first of a range increases along with its parameter
+static constexpr const uint8_t kCCPot1 = 20;
+static constexpr const uint8_t kCCFoot1 = 17;
+static constexpr const uint8_t kCCExpPedal = 89;
+
+// used in kCCToParam for CCs without a parameter
+static constexpr const uint8_t kCCUnbound = 0xff;
+
+struct BindingTables {
+   uint8_t paramToCC[kParamBindingCount];
+   uint8_t ccToParam[128];
+   bool valid;
 };
+
+static constexpr BindingTables makeBindingTables()
+{
+   BindingTables tables = {};
+
+   for (uint32_t i = kParamPot1; i <= kParamPot6; ++i)
+      tables.paramToCC[i] = kCCPot1 + i - kParamPot1;
+
+   for (uint32_t i = kParamFoot1; i <= kParamFoot3; ++i)
+      tables.paramToCC[i] = kCCFoot1 + i - kParamFoot1;
+
+   tables.paramToCC[kParamExpPedal] = kCCExpPedal;
+
+   for (uint32_t i = kParamCCs; i < kParamBindingCount; ++i)
+      tables.paramToCC[i] = kAllowedCCs[i - kParamCCs];
+
+   // reverse index, flagging out-of-range CCs and collisions
+   tables.valid = true;
+
+   for (uint32_t cc = 0; cc < 128; ++cc)
+      tables.ccToParam[cc] = kCCUnbound;
+
+   for (uint32_t i = 0; i < kParamBindingCount; ++i)
+   {
+      const uint8_t cc = tables.paramToCC[i];
+
+      if (cc >= 128 || tables.ccToParam[cc] != kCCUnbound)
+      {
+         tables.valid = false;
+         continue;
+      }
+
+      tables.ccToParam[cc] = i;
+   }
+
+   return tables;
+}
+
+static constexpr const BindingTables kBindingTables = makeBindingTables();
+static_assert(kBindingTables.valid, "parameter CC bindings must be unique and within 0-127");
+static_assert(kParamBindingCount < kCCUnbound, "too many parameter CC bindings");
+
+/**
+   Parameter to CC lookup, valid for indexes below kParamBindingCount.
+ */
+static constexpr const uint8_t (&kParamToCC)[kParamBindingCount] = kBindingTables.paramToCC;
+
+/**
+   CC to parameter lookup, kCCUnbound for CCs not bound to any parameter.
+ */
+static constexpr const uint8_t (&kCCToParam)[128] = kBindingTables.ccToParam;
+
+static_assert(kParamToCC[kParamPot1] == 20 && kParamToCC[kParamPot6] == 25, "wrong pot bindings");
+static_assert(kParamToCC[kParamFoot1] == 17 && kParamToCC[kParamFoot3] == 19, "wrong footswitch bindings");
+static_assert(kCCToParam[kCCExpPedal] == kParamExpPedal, "wrong expression pedal binding");
@@ -0,0 +1,113 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "LinkGovernor.hpp"
+
+#include <cmath>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Assigns frame offsets to outgoing events so they are evenly spaced instead of piling up at frame 0.
+
+   Each event takes the next free slot, and the one after it becomes available @a spacing frames later.
+   Slots past the end of the current block are carried over into the next one,
+   so an event left pending lands exactly @a spacing frames after the previous one, even across blocks.
+
+   On top of the spacing, the bandwidth of the physical link is modelled with a LinkGovernor,
+   so an event is also held back until the link has had time to transmit everything sent before it.
+
+   Usage per block is beginBlock(), then getNextFrame() + advance() for every event written, then endBlock().
+   A spacing of 0 with an unlimited link places every event at frame 0, same as no scheduling at all.
+ */
+class EventScheduler
+{
+    LinkGovernor governor;
+    uint32_t spacing = 0;
+    uint32_t blockFrames = 0;
+    uint32_t nextFrame = 0;
+
+public:
+    EventScheduler() noexcept = default;
+
+    void setSpacing(const uint32_t frames) noexcept
+    {
+        spacing = frames;
+    }
+
+    void setLinkRate(const uint32_t baudRate, const double sampleRate) noexcept
+    {
+        governor.setRate(baudRate, sampleRate);
+    }
+
+    void reset() noexcept
+    {
+        governor.reset();
+        nextFrame = 0;
+    }
+
+    void beginBlock(const uint32_t frames) noexcept
+    {
+        blockFrames = frames;
+    }
+
+   /**
+      Get the frame where the next event, of @a size bytes, should be placed.
+      The event is never placed before @a minFrame, used for events that have a time of their own.
+      Returns false if there is no free slot left within the current block.
+    */
+    bool getNextFrame(const uint32_t size, uint32_t& frame, const uint32_t minFrame = 0) const noexcept
+    {
+        const uint32_t start = std::max(nextFrame, minFrame);
+
+        if (start >= blockFrames)
+            return false;
+
+        const double earliest = std::ceil(governor.getEarliestTime(start, size));
+
+        if (earliest >= blockFrames)
+            return false;
+
+        frame = static_cast<uint32_t>(earliest);
+        return true;
+    }
+
+   /**
+      Mark the slot returned by getNextFrame() as used.
+    */
+    void advance(const uint32_t frame, const uint32_t size) noexcept
+    {
+        governor.consume(frame, size);
+        nextFrame = frame + spacing;
+    }
+
+   /**
+      Account for an event placed by someone else at a fixed @a frame, such as MIDI thru.
+      Following events keep their spacing from it and share the link bandwidth with it.
+    */
+    void reserve(const uint32_t frame, const uint32_t size) noexcept
+    {
+        governor.consume(frame, size);
+        nextFrame = std::max(nextFrame, frame + spacing);
+    }
+
+   /**
+      Carry over any remaining spacing and link usage into the next block.
+    */
+    void endBlock() noexcept
+    {
+        governor.endBlock(blockFrames);
+        nextFrame = nextFrame > blockFrames ? nextFrame - blockFrames : 0;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
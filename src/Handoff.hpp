@@ -0,0 +1,92 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <atomic>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Hand over objects created on the control side to the realtime side, without locks and without ever deleting on it.
+
+   The control side publishes a new object, which the realtime side takes whenever it is ready for it.
+   The object it replaces is retired and deleted by the control side on the next publish, or on destruction.
+   All objects still owned are deleted on destruction.
+
+   A publish can race with the realtime side taking the previous object, so up to 2 objects may be retired
+   between 2 publish calls, each one gets its own retire slot so none is lost.
+ */
+template <class T>
+class Handoff
+{
+    std::atomic<T*> pending { nullptr };
+    std::atomic<T*> retired[2] = { { nullptr }, { nullptr } };
+    std::atomic<T*> current { nullptr };
+
+public:
+    Handoff() noexcept = default;
+
+    ~Handoff()
+    {
+        delete pending.load(std::memory_order_acquire);
+        delete retired[0].load(std::memory_order_acquire);
+        delete retired[1].load(std::memory_order_acquire);
+        delete current.load(std::memory_order_acquire);
+    }
+
+   /**
+      Publish a new object, which is owned by this class from now on.
+      Must always be called from the same thread.
+    */
+    void publish(T* const object)
+    {
+        delete retired[0].exchange(nullptr, std::memory_order_acquire);
+        delete retired[1].exchange(nullptr, std::memory_order_acquire);
+
+        // never seen by the realtime side, safe to delete
+        delete pending.exchange(object, std::memory_order_acq_rel);
+    }
+
+   /**
+      Get the object currently in use by the realtime side, from the thread calling publish().
+      Stays valid until the next publish() call.
+    */
+    const T* getCurrent() const noexcept
+    {
+        return current.load(std::memory_order_acquire);
+    }
+
+   /**
+      Realtime side, take the last published object if there is one.
+      Returns the object now in use, which may be the same as before or null if nothing was ever published.
+    */
+    T* take() noexcept
+    {
+        if (T* const next = pending.exchange(nullptr, std::memory_order_acquire))
+        {
+            T* const old = current.exchange(next, std::memory_order_acq_rel);
+
+            // the control side only ever clears these, so a free slot stays free until stored into
+            if (retired[0].load(std::memory_order_acquire) == nullptr)
+                retired[0].store(old, std::memory_order_release);
+            else
+                retired[1].store(old, std::memory_order_release);
+        }
+
+        return current.load(std::memory_order_relaxed);
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(Handoff)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
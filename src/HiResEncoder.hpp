@@ -0,0 +1,217 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Encodes 14-bit controller values, either as MSB/LSB controller pairs or as NRPNs.
+
+   The encoder keeps track of what the receiver last got (controller MSBs and LSBs, selected NRPN and the data of each
+   of our NRPNs), based on all CCs written to the stream, so that only the messages needed to reach a new value are sent.
+   On slow sweeps the MSB rarely changes, which brings most changes down to a single LSB message,
+   plus the NRPN selection when changing between controllers.
+
+   As per the MIDI spec, receivers reset the LSB whenever a new MSB arrives, so an LSB always follows an MSB.
+   Only MSB controllers 0-31 have an LSB pair, others can only be sent in high resolution as NRPN.
+ */
+class HiResEncoder
+{
+public:
+    enum Mode {
+        kModeOff,
+        kModeCC,
+        kModeNRPN,
+        kModeCount
+    };
+
+    static constexpr const uint16_t kMaxValue = 16383;
+
+    HiResEncoder() noexcept
+    {
+        reset();
+    }
+
+   /**
+      Forget everything about the receiver, all values are sent in full afterwards.
+    */
+    void reset() noexcept
+    {
+        std::fill(std::begin(msbs), std::end(msbs), kUnknown);
+        std::fill(std::begin(lsbs), std::end(lsbs), kUnknown);
+        nrpnMsb = nrpnLsb = kUnknown;
+        forgetData();
+    }
+
+   /**
+      Check if controller @a cc can be sent in high resolution with @a mode.
+    */
+    static bool supports(const uint32_t mode, const uint8_t cc) noexcept
+    {
+        switch (mode)
+        {
+        case kModeCC:
+            return cc < 32;
+        case kModeNRPN:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+   /**
+      Update the receiver state with a CC written to the stream, from any source.
+    */
+    void observe(const uint8_t cc, const uint8_t value) noexcept
+    {
+        switch (cc)
+        {
+        case 6:
+            if (isSelectionKnown())
+            {
+                if (nrpnMsb == 0)
+                {
+                    dataMsbs[nrpnLsb] = value;
+                    dataLsbs[nrpnLsb] = kUnknown;
+                }
+            }
+            else
+            {
+                forgetData();
+            }
+            break;
+        case 38:
+            if (isSelectionKnown())
+            {
+                if (nrpnMsb == 0)
+                    dataLsbs[nrpnLsb] = value;
+            }
+            else
+            {
+                forgetData();
+            }
+            break;
+        case 96: // data increment
+        case 97: // data decrement
+            if (isSelectionKnown())
+            {
+                if (nrpnMsb == 0)
+                    dataMsbs[nrpnLsb] = dataLsbs[nrpnLsb] = kUnknown;
+            }
+            else
+            {
+                forgetData();
+            }
+            return;
+        case 98:
+            nrpnLsb = value;
+            return;
+        case 99:
+            nrpnMsb = value;
+            return;
+        case 100: // RPN, deselects the current NRPN
+        case 101:
+            nrpnMsb = nrpnLsb = kRPN;
+            return;
+        }
+
+        /**/ if (cc < 32)
+        {
+            msbs[cc] = value;
+            lsbs[cc] = kUnknown;
+        }
+        else if (cc < 64)
+        {
+            lsbs[cc - 32] = value;
+        }
+    }
+
+   /**
+      Forget the value of controller @a cc, for when the receiver changed it by itself.
+    */
+    void forget(const uint8_t cc) noexcept
+    {
+        if (cc < 32)
+            msbs[cc] = lsbs[cc] = kUnknown;
+
+        dataMsbs[cc] = dataLsbs[cc] = kUnknown;
+    }
+
+   /**
+      Get the next CC needed to send @a value for controller @a cc, as NRPN 0:cc in NRPN mode.
+      Returns false once the receiver is known to have the value, the returned CC must be written before calling again.
+    */
+    bool getNext(const uint32_t mode, const uint8_t cc, const uint16_t value, uint8_t& outCC, uint8_t& outValue) const noexcept
+    {
+        const uint8_t msb = value >> 7;
+        const uint8_t lsb = value & 0x7f;
+
+        switch (mode)
+        {
+        case kModeCC:
+            DISTRHO_SAFE_ASSERT_RETURN(cc < 32, false);
+
+            /**/ if (msbs[cc] != msb)
+                return set(cc, msb, outCC, outValue);
+            else if (lsbs[cc] != lsb)
+                return set(cc + 32, lsb, outCC, outValue);
+            break;
+
+        case kModeNRPN:
+            /**/ if (nrpnMsb != 0)
+                return set(99, 0, outCC, outValue);
+            else if (nrpnLsb != cc)
+                return set(98, cc, outCC, outValue);
+            else if (dataMsbs[cc] != msb)
+                return set(6, msb, outCC, outValue);
+            else if (dataLsbs[cc] != lsb)
+                return set(38, lsb, outCC, outValue);
+            break;
+        }
+
+        return false;
+    }
+
+private:
+    static constexpr const int16_t kUnknown = -1;
+    static constexpr const int16_t kRPN = -2;
+
+    int16_t msbs[32];
+    int16_t lsbs[32];
+    int16_t nrpnMsb, nrpnLsb;
+    int16_t dataMsbs[128];
+    int16_t dataLsbs[128];
+
+    // data entry goes to an unknown parameter, which could be any of ours
+    bool isSelectionKnown() const noexcept
+    {
+        return nrpnMsb != kUnknown && nrpnLsb != kUnknown;
+    }
+
+    void forgetData() noexcept
+    {
+        std::fill(std::begin(dataMsbs), std::end(dataMsbs), kUnknown);
+        std::fill(std::begin(dataLsbs), std::end(dataLsbs), kUnknown);
+    }
+
+    static bool set(const uint8_t cc, const uint8_t value, uint8_t& outCC, uint8_t& outValue) noexcept
+    {
+        outCC = cc;
+        outValue = value;
+        return true;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,119 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Perfect hash of a fixed set of string keys, built at compile time.
+
+   A seed is searched for so that every key lands on its own slot, lookups then take a single hash and string compare.
+   Keys are identified by their position in the array given on construction, which must outlive this object.
+   @code
+   static constexpr const char* const kNames[] = { "bank", "preset" };
+   static constexpr const KeyDispatch<std::size(kNames)> kKeys(kNames);
+   static_assert(kKeys.isValid(), "no perfect hash for these keys");
+   @endcode
+ */
+template <size_t kCount>
+class KeyDispatch
+{
+public:
+    static constexpr const uint32_t kNotFound = UINT32_MAX;
+
+    constexpr explicit KeyDispatch(const char* const (&keys_)[kCount]) noexcept
+        : keys(keys_),
+          seed(findSeed(keys_)),
+          slots()
+    {
+        for (uint32_t i = 0; i < kSize; ++i)
+            slots[i] = kNotFound;
+
+        for (uint32_t i = 0; i < kCount; ++i)
+            slots[hash(keys_[i], seed) & (kSize - 1)] = i;
+    }
+
+    constexpr bool isValid() const noexcept
+    {
+        return seed != 0;
+    }
+
+   /**
+      Get the position of @a key in the original array, or kNotFound.
+    */
+    uint32_t lookup(const char* const key) const noexcept
+    {
+        const uint32_t index = slots[hash(key, seed) & (kSize - 1)];
+
+        if (index == kNotFound || std::strcmp(keys[index], key) != 0)
+            return kNotFound;
+
+        return index;
+    }
+
+private:
+    // power of 2 with at least four times as many slots as keys, so that a seed is found quickly
+    // (twice as many is not enough past a dozen keys, the search runs out of seeds)
+    static constexpr uint32_t getSize() noexcept
+    {
+        uint32_t size = 2;
+        while (size < kCount * 4)
+            size *= 2;
+        return size;
+    }
+
+    static constexpr const uint32_t kSize = getSize();
+
+    const char* const* keys;
+    uint32_t seed;
+    uint32_t slots[kSize];
+
+    // FNV-1a, with the seed mixed into the offset basis
+    static constexpr uint32_t hash(const char* key, const uint32_t seed) noexcept
+    {
+        uint32_t h = 2166136261u ^ (seed * 0x9e3779b9u);
+
+        while (*key != '\0')
+        {
+            h ^= static_cast<uint8_t>(*key++);
+            h *= 16777619u;
+        }
+
+        return h;
+    }
+
+    static constexpr uint32_t findSeed(const char* const (&keys_)[kCount]) noexcept
+    {
+        for (uint32_t seed = 1; seed < 10000; ++seed)
+        {
+            bool used[kSize] = {};
+            bool collision = false;
+
+            for (uint32_t i = 0; i < kCount && ! collision; ++i)
+            {
+                const uint32_t slot = hash(keys_[i], seed) & (kSize - 1);
+                collision = used[slot];
+                used[slot] = true;
+            }
+
+            if (! collision)
+                return seed;
+        }
+
+        return 0;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,101 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Histogram of latencies in microseconds, with fixed-size bins so adding a value is constant time and never allocates.
+   Values past the last bin are counted in it, percentiles are reported as the upper edge of their bin.
+ */
+template <uint32_t kNumBins, uint32_t kBinWidth>
+class LatencyHistogram
+{
+    uint32_t bins[kNumBins] = {};
+    uint32_t count = 0;
+    uint32_t min = UINT32_MAX;
+    uint32_t max = 0;
+
+public:
+    LatencyHistogram() noexcept = default;
+
+    void clear() noexcept
+    {
+        std::fill(std::begin(bins), std::end(bins), 0);
+        count = 0;
+        min = UINT32_MAX;
+        max = 0;
+    }
+
+    void add(const uint32_t micros) noexcept
+    {
+        ++bins[std::min(micros / kBinWidth, kNumBins - 1)];
+        ++count;
+        min = std::min(min, micros);
+        max = std::max(max, micros);
+    }
+
+    uint32_t getCount() const noexcept
+    {
+        return count;
+    }
+
+    uint32_t getMin() const noexcept
+    {
+        return count != 0 ? min : 0;
+    }
+
+    uint32_t getMax() const noexcept
+    {
+        return max;
+    }
+
+   /**
+      Get the number of values in all bins from @a first up to, but not including, @a last.
+    */
+    uint32_t getCount(const uint32_t first, const uint32_t last) const noexcept
+    {
+        uint32_t total = 0;
+
+        for (uint32_t i = first; i < std::min(last, kNumBins); ++i)
+            total += bins[i];
+
+        return total;
+    }
+
+   /**
+      Get the latency under which @a percent of all values fall.
+    */
+    uint32_t getPercentile(const double percent) const noexcept
+    {
+        if (count == 0)
+            return 0;
+
+        const uint32_t target = std::max<uint32_t>(1, static_cast<uint32_t>(count * percent / 100.0 + 0.5));
+        uint32_t seen = 0;
+
+        for (uint32_t i = 0; i < kNumBins; ++i)
+        {
+            seen += bins[i];
+
+            if (seen >= target)
+                return std::min((i + 1) * kBinWidth, max);
+        }
+
+        return max;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
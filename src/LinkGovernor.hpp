@@ -0,0 +1,111 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Token bucket modelling the bandwidth of a physical MIDI link.
+
+   Tokens are bytes, refilled at the link rate and capped at the burst size.
+   All times are in frames relative to the start of the current block, fractional frames are kept between blocks.
+   A rate of 0 means unlimited bandwidth, every request is granted immediately.
+ */
+class LinkGovernor
+{
+    static constexpr const double kBurstBytes = 3.0;
+
+    double bytesPerFrame = 0.0;
+    double tokens = kBurstBytes;
+    double stamp = 0.0;
+
+    double getTokensAt(const double time) const noexcept
+    {
+        return std::min(kBurstBytes, tokens + (time - stamp) * bytesPerFrame);
+    }
+
+public:
+    LinkGovernor() noexcept = default;
+
+   /**
+      Set the link rate in baud, assuming 10 bits on the wire per byte (8 data, 1 start, 1 stop).
+    */
+    void setRate(const uint32_t baudRate, const double sampleRate) noexcept
+    {
+        bytesPerFrame = baudRate != 0 && sampleRate > 0.0 ? baudRate / 10.0 / sampleRate : 0.0;
+    }
+
+    bool isUnlimited() const noexcept
+    {
+        return bytesPerFrame <= 0.0;
+    }
+
+    void reset() noexcept
+    {
+        tokens = kBurstBytes;
+        stamp = 0.0;
+    }
+
+   /**
+      Get the earliest time, at or after @a time, at which @a size bytes can go through the link.
+    */
+    double getEarliestTime(const double time, const uint32_t size) const noexcept
+    {
+        if (isUnlimited())
+            return time;
+
+        const double available = getTokensAt(time);
+
+        if (available >= size)
+            return time;
+
+        return time + (size - available) / bytesPerFrame;
+    }
+
+   /**
+      Take @a size bytes from the bucket at @a time, which should not be earlier than getEarliestTime() allows.
+      Events at a fixed time may take more than available, delaying the ones after them.
+    */
+    void consume(const double time, const uint32_t size) noexcept
+    {
+        if (isUnlimited())
+            return;
+
+        const double now = std::max(time, stamp);
+        tokens = getTokensAt(now) - size;
+        stamp = now;
+    }
+
+   /**
+      Move the time reference to the start of the next block.
+    */
+    void endBlock(const uint32_t frames) noexcept
+    {
+        if (isUnlimited())
+            return;
+
+        if (stamp < frames)
+        {
+            tokens = getTokensAt(frames);
+            stamp = 0.0;
+        }
+        else
+        {
+            stamp -= frames;
+        }
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,185 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+#include <cstdio>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Streaming writer of single-track Standard MIDI Files (format 0).
+
+   Events are written to disk as they come, memory use is constant regardless of the length of the file.
+   The track length is only known at the end, so it is patched in place when closing.
+
+   Timing is set up so that one tick is one sample: a tempo of 10ms per quarter note and
+   a division of sampleRate / 100 ticks per quarter note, which is exact for all common sample rates.
+
+   Delta times are limited to 0x0FFFFFFF ticks by the format, about 93 minutes at 48kHz.
+   Longer gaps are split with empty text events, which cancel running status,
+   so the writer puts the status byte back in front of the next event that relies on it.
+ */
+class MidiFileWriter
+{
+public:
+    MidiFileWriter() noexcept = default;
+
+    ~MidiFileWriter()
+    {
+        close();
+    }
+
+    bool open(const char* const filename, const double sampleRate)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(file == nullptr, false);
+        DISTRHO_SAFE_ASSERT_RETURN(sampleRate >= 100.0, false);
+
+        file = std::fopen(filename, "wb");
+        DISTRHO_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+        const uint32_t division = std::min(static_cast<uint32_t>(sampleRate / 100.0 + 0.5), 0x7fffu);
+        ticksPerFrame = division * 100.0 / sampleRate;
+        lastTick = 0;
+        trackSize = 0;
+        runningStatus = 0;
+        runningStatusActive = false;
+
+        static constexpr const uint8_t kHeader[] = {
+            'M', 'T', 'h', 'd', 0, 0, 0, 6,
+            0, 0, // format 0
+            0, 1, // 1 track
+        };
+        std::fwrite(kHeader, 1, sizeof(kHeader), file);
+        writeBE(division, 2);
+
+        std::fwrite("MTrk", 1, 4, file);
+        trackSizePos = std::ftell(file);
+        writeBE(0, 4);
+
+        // tempo of 10000us per quarter note
+        static constexpr const uint8_t kTempo[] = { 0xFF, 0x51, 0x03, 0x00, 0x27, 0x10 };
+        writeEvent(0, kTempo, sizeof(kTempo));
+
+        return std::ferror(file) == 0;
+    }
+
+   /**
+      Write an event at @a frame, counted from the start of the file.
+      Data is written as-is, so it may already omit the status byte for running status.
+    */
+    bool write(const uint64_t frame, const uint8_t* const data, const uint32_t size)
+    {
+        DISTRHO_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+        writeEvent(static_cast<uint64_t>(frame * ticksPerFrame + 0.5), data, size);
+        return std::ferror(file) == 0;
+    }
+
+    bool close()
+    {
+        if (file == nullptr)
+            return false;
+
+        static constexpr const uint8_t kEndOfTrack[] = { 0xFF, 0x2F, 0x00 };
+        writeEvent(lastTick, kEndOfTrack, sizeof(kEndOfTrack));
+
+        std::fseek(file, trackSizePos, SEEK_SET);
+        writeBE(trackSize, 4);
+
+        const bool ok = std::ferror(file) == 0;
+        const bool closed = std::fclose(file) == 0;
+        file = nullptr;
+        return ok && closed;
+    }
+
+private:
+    FILE* file = nullptr;
+    double ticksPerFrame = 1.0;
+    uint64_t lastTick = 0;
+    uint32_t trackSize = 0;
+    long trackSizePos = 0;
+    uint8_t runningStatus = 0;
+    bool runningStatusActive = false;
+
+    static constexpr const uint32_t kMaxDelta = 0x0FFFFFFF;
+
+    void writeEvent(uint64_t tick, const uint8_t* const data, const uint32_t size)
+    {
+        // never go back in time, events within the same tick keep their order
+        if (tick < lastTick)
+            tick = lastTick;
+
+        while (tick - lastTick > kMaxDelta)
+        {
+            static constexpr const uint8_t kEmptyText[] = { 0xFF, 0x01, 0x00 };
+            writeVarLen(kMaxDelta);
+            std::fwrite(kEmptyText, 1, sizeof(kEmptyText), file);
+            trackSize += sizeof(kEmptyText);
+            lastTick += kMaxDelta;
+            runningStatusActive = false;
+        }
+
+        writeVarLen(static_cast<uint32_t>(tick - lastTick));
+        lastTick = tick;
+
+        if (size == 0)
+            return;
+
+        /**/ if (data[0] >= 0xF0)
+        {
+            runningStatusActive = false;
+        }
+        else if (data[0] >= 0x80)
+        {
+            runningStatus = data[0];
+            runningStatusActive = true;
+        }
+        else if (! runningStatusActive && runningStatus != 0)
+        {
+            std::fputc(runningStatus, file);
+            ++trackSize;
+            runningStatusActive = true;
+        }
+
+        std::fwrite(data, 1, size, file);
+        trackSize += size;
+    }
+
+    void writeBE(const uint32_t value, const uint32_t size)
+    {
+        for (uint32_t i = size; i-- != 0;)
+            std::fputc((value >> (i * 8)) & 0xff, file);
+    }
+
+    // big-endian groups of 7 bits, as used by the SMF format
+    void writeVarLen(uint32_t value)
+    {
+        uint8_t buf[4];
+        uint32_t size = 0;
+
+        buf[size++] = value & 0x7f;
+
+        while ((value >>= 7) != 0)
+            buf[size++] = 0x80 | (value & 0x7f);
+
+        trackSize += size;
+
+        while (size != 0)
+            std::fputc(buf[--size], file);
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(MidiFileWriter)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
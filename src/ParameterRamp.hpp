@@ -0,0 +1,98 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Linear ramp from the current value into a target, over a fixed number of frames.
+
+   Setting a different target while ramping starts over from wherever the ramp currently is,
+   so the time to reach a target is always the same regardless of the distance.
+   The first target after clear() is reached immediately, as there is nothing to ramp from.
+ */
+class ParameterRamp
+{
+    double value = 0.0;
+    double target = 0.0;
+    double step = 0.0;
+    uint32_t remaining = 0;
+    bool valid = false;
+
+public:
+    ParameterRamp() noexcept = default;
+
+    void clear() noexcept
+    {
+        remaining = 0;
+        valid = false;
+    }
+
+    void jump(const double newValue) noexcept
+    {
+        value = target = newValue;
+        remaining = 0;
+        valid = true;
+    }
+
+    void setTarget(const double newTarget, const uint32_t frames) noexcept
+    {
+        if (! valid || frames == 0)
+            return jump(newTarget);
+
+        // hosts often repeat the same value, which must not restart the ramp
+        if (newTarget == target)
+            return;
+
+        target = newTarget;
+        step = (target - value) / frames;
+        remaining = frames;
+    }
+
+    bool isActive() const noexcept
+    {
+        return remaining != 0;
+    }
+
+   /**
+      Check if the ramp is still moving @a offset frames from now.
+    */
+    bool isActiveAt(const uint32_t offset) const noexcept
+    {
+        return offset < remaining;
+    }
+
+   /**
+      Get the value @a offset frames from now, without advancing the ramp.
+    */
+    double getValueAt(const uint32_t offset) const noexcept
+    {
+        return offset < remaining ? value + step * offset : target;
+    }
+
+    void advance(const uint32_t frames) noexcept
+    {
+        if (frames < remaining)
+        {
+            value += step * frames;
+            remaining -= frames;
+        }
+        else
+        {
+            value = target;
+            remaining = 0;
+        }
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,132 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Counters and timing of the realtime side, accumulated over a window of a fraction of a second.
+
+   Only ever touched by the audio thread, so there is no synchronization within.
+   Once a window is complete its results are made available as a snapshot of rates and timings,
+   which the caller publishes to other threads (in our case through output parameters).
+ */
+class RealtimeStats
+{
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct Snapshot {
+        float emitted;  // events per second
+        float deferred; // events per second
+        float rejected; // events per second
+        float dropped;  // events per second
+        uint32_t maxPending;
+        float minRun;   // microseconds
+        float avgRun;   // microseconds
+        float maxRun;   // microseconds
+    };
+
+    RealtimeStats() noexcept = default;
+
+    void reset() noexcept
+    {
+        emitted = deferred = rejected = dropped = 0;
+        maxPending = 0;
+        runs = 0;
+        frames = 0;
+        minRun = std::numeric_limits<double>::max();
+        maxRun = totalRun = 0.0;
+    }
+
+    // event written to the host
+    void addEmitted() noexcept
+    {
+        ++emitted;
+    }
+
+    // event held back for a later block, due to scheduling or the host running out of room
+    void addDeferred() noexcept
+    {
+        ++deferred;
+    }
+
+    // event the host had no room for
+    void addRejected() noexcept
+    {
+        ++rejected;
+    }
+
+    // events thrown away
+    void addDropped(const uint32_t count) noexcept
+    {
+        dropped += count;
+    }
+
+   /**
+      Account for a complete run() call of @a blockFrames that started at @a start,
+      with @a pending events still waiting to be sent.
+      Returns true and fills @a snapshot when the current window is complete, at which point a new one begins.
+    */
+    bool endRun(const Clock::time_point start,
+                const uint32_t blockFrames,
+                const uint32_t pending,
+                const double sampleRate,
+                Snapshot& snapshot) noexcept
+    {
+        const double duration = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+
+        minRun = std::min(minRun, duration);
+        maxRun = std::max(maxRun, duration);
+        totalRun += duration;
+        maxPending = std::max(maxPending, pending);
+        ++runs;
+        frames += blockFrames;
+
+        if (frames < sampleRate * kWindow)
+            return false;
+
+        const double scale = sampleRate / frames;
+        snapshot.emitted = emitted * scale;
+        snapshot.deferred = deferred * scale;
+        snapshot.rejected = rejected * scale;
+        snapshot.dropped = dropped * scale;
+        snapshot.maxPending = maxPending;
+        snapshot.minRun = minRun;
+        snapshot.avgRun = totalRun / runs;
+        snapshot.maxRun = maxRun;
+
+        reset();
+        return true;
+    }
+
+private:
+    static constexpr const double kWindow = 0.5;
+
+    uint32_t emitted = 0;
+    uint32_t deferred = 0;
+    uint32_t rejected = 0;
+    uint32_t dropped = 0;
+    uint32_t maxPending = 0;
+    uint32_t runs = 0;
+    uint32_t frames = 0;
+    double minRun = std::numeric_limits<double>::max();
+    double maxRun = 0.0;
+    double totalRun = 0.0;
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
@@ -0,0 +1,79 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoUtils.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Encodes MIDI messages into a serial byte stream using running status,
+   where a channel message repeating the previous status byte is sent without it.
+
+   Running status is restarted, forcing the next message to carry its full status byte:
+    - after a Program Change, as the Anagram treats it as a hard boundary between commands
+    - after any System Common or System Exclusive message, as mandated by the MIDI spec
+    - whenever reset() is called, typically at block boundaries where the host may merge or reorder streams
+
+   System Real-Time messages are passed through and do not affect running status.
+ */
+class RunningStatusEncoder
+{
+    uint8_t runningStatus = 0;
+
+public:
+    RunningStatusEncoder() noexcept = default;
+
+    void reset() noexcept
+    {
+        runningStatus = 0;
+    }
+
+   /**
+      Get how many bytes @a data would take on the wire, without changing the encoder state.
+    */
+    uint32_t getEncodedSize(const uint8_t* const data, const uint32_t size) const noexcept
+    {
+        return size != 0 && data[0] == runningStatus ? size - 1 : size;
+    }
+
+   /**
+      Update the encoder state as if @a data had been written to the stream.
+    */
+    void commit(const uint8_t* const data, const uint32_t size) noexcept
+    {
+        if (size == 0)
+            return;
+
+        const uint8_t status = data[0];
+
+        /**/ if (status >= 0xF8)
+            return;
+        else if (status >= 0xF0 || (status & 0xF0) == 0xC0)
+            runningStatus = 0;
+        else if (status >= 0x80)
+            runningStatus = status;
+    }
+
+   /**
+      Write @a data into @a out using running status, returns the number of bytes written.
+      @a out must have room for at least @a size bytes.
+    */
+    uint32_t encode(const uint8_t* const data, const uint32_t size, uint8_t* const out) noexcept
+    {
+        const uint32_t encodedSize = getEncodedSize(data, size);
+        std::memcpy(out, data + (size - encodedSize), encodedSize);
+        commit(data, size);
+        return encodedSize;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
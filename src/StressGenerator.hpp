@@ -0,0 +1,157 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "DistrhoPlugin.hpp"
+#include "CommandQueue.hpp"
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+enum StressModes {
+    kStressOff,
+    kStressSweep,
+    kStressStorm,
+    kStressRandom,
+    kStressModeCount
+};
+
+/**
+   Generator of repeatable command streams for load-testing the device.
+
+   - Sweep goes through all generic CCs in turn, each one moving up and down its full range
+   - Storm sends bank, preset and scene increments and decrements in a random order
+   - Random mixes controller changes with absolute and relative actions, all within valid ranges
+
+   The same mode and seed always produce the same stream, which is restarted whenever either changes.
+   Commands are only generated here, timing and encoding are left to the caller.
+ */
+class StressGenerator
+{
+    uint32_t mode = kStressOff;
+    uint32_t seed = 0;
+    uint64_t random = 0;
+    uint32_t step = 0;
+    Command current = {};
+
+    uint32_t nextRandom(const uint32_t range) noexcept
+    {
+        // xorshift64*
+        random ^= random >> 12;
+        random ^= random << 25;
+        random ^= random >> 27;
+        return static_cast<uint32_t>(((random * 0x2545f4914f6cdd1dull) >> 32) % range);
+    }
+
+    void generate() noexcept
+    {
+        static constexpr const Command kSteps[] = {
+            { kCommandAction, kActionBank, kActionStepNext, 0 },
+            { kCommandAction, kActionBank, kActionStepPrevious, 0 },
+            { kCommandAction, kActionPreset, kActionStepNext, 0 },
+            { kCommandAction, kActionPreset, kActionStepPrevious, 0 },
+            { kCommandAction, kActionScene, kActionStepNext, 0 },
+            { kCommandAction, kActionScene, kActionStepPrevious, 0 },
+        };
+
+        switch (mode)
+        {
+        case kStressSweep: {
+            static constexpr const uint32_t kNumCCs = std::size(kAllowedCCs);
+            const uint32_t position = step / kNumCCs % 254;
+            current.type = kCommandParameter;
+            current.index = kParamCCs + step % kNumCCs;
+            current.value = position < 127 ? position : 254 - position;
+            break;
+        }
+        case kStressStorm:
+            current = kSteps[nextRandom(std::size(kSteps))];
+            break;
+        case kStressRandom:
+            switch (nextRandom(8))
+            {
+            default:
+                current.type = kCommandParameter;
+                current.index = nextRandom(kParamBindingCount);
+                current.value = current.index >= kParamFoot1 && current.index <= kParamFoot3
+                              ? nextRandom(2) * 127
+                              : nextRandom(128);
+                break;
+            case 0:
+                current = kSteps[nextRandom(std::size(kSteps))];
+                break;
+            case 1:
+                current.type = kCommandAction;
+                current.index = kActionBank;
+                current.value = 1 + nextRandom(42); // 1-based, same as the UI and state
+                break;
+            case 2:
+                current.type = kCommandAction;
+                current.index = kActionPreset;
+                current.value = 1 + nextRandom(126);
+                break;
+            case 3:
+                current.type = kCommandAction;
+                current.index = kActionScene;
+                current.value = nextRandom(4);
+                break;
+            }
+            break;
+        }
+    }
+
+public:
+    StressGenerator() noexcept = default;
+
+    bool isEnabled() const noexcept
+    {
+        return mode != kStressOff;
+    }
+
+   /**
+      Change mode and seed, restarting the stream if any of them differs from the current one.
+    */
+    void configure(const uint32_t newMode, const uint32_t newSeed) noexcept
+    {
+        if (newMode == mode && newSeed == seed)
+            return;
+
+        mode = newMode < kStressModeCount ? newMode : static_cast<uint32_t>(kStressOff);
+        seed = newSeed;
+        reset();
+    }
+
+    void reset() noexcept
+    {
+        // splitmix64 of the seed, so that close seeds still give unrelated streams and 0 is valid
+        uint64_t z = seed + 0x9e3779b97f4a7c15ull;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+        random = (z ^ (z >> 31)) | 1;
+        step = 0;
+        generate();
+    }
+
+   /**
+      The command to send next, stays the same until advance() is called.
+    */
+    const Command& peek() const noexcept
+    {
+        return current;
+    }
+
+    void advance() noexcept
+    {
+        ++step;
+        generate();
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
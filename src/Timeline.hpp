@@ -0,0 +1,341 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+#pragma once
+
+#include "CommandQueue.hpp"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+
+START_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+/**
+   Recorded commands with sample timestamps, kept sorted by frame.
+
+   Commands from the host and UI are taken by the realtime side once per block,
+   so while playback is sample accurate, recorded timing is only as fine as the host block size.
+
+   Storage is allocated once on creation, appending is realtime-safe and never reallocates.
+   There is a single writer (the realtime side while recording) but readers may look at the events
+   already appended from any thread, as the event count is only published after the event itself is written.
+
+   Timelines can be saved to and loaded from a compact binary file, which is not realtime-safe.
+   Frames are delta-encoded and all integers stored as variable-length, so a typical event takes 4 to 6 bytes.
+   The sample rate is stored along with the events, loading rescales frames to the current rate.
+
+   Files too long to be loaded at once can be read in parts with a Reader, into timelines that hold a window
+   of the file, each one knowing where its first event is within the whole file.
+ */
+class Timeline
+{
+public:
+    struct Event {
+        uint64_t frame;
+        Command command;
+    };
+    static_assert(std::is_trivially_default_constructible<Event>::value, "events must not be touched on allocation");
+
+    explicit Timeline(const uint32_t capacity_, const uint64_t offset_ = 0)
+        : events(new Event[capacity_]),
+          capacity(capacity_),
+          offset(offset_) {}
+
+    ~Timeline()
+    {
+        delete[] events;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // realtime side
+
+   /**
+      Append a command, a @a frame lower than the one of the last event (e.g. transport moved back) is raised to it.
+      Returns false if the timeline is full.
+    */
+    bool append(uint64_t frame, const Command& command) noexcept
+    {
+        const uint32_t index = count.load(std::memory_order_relaxed);
+
+        if (index == capacity)
+            return false;
+
+        if (index != 0 && frame < events[index - 1].frame)
+            frame = events[index - 1].frame;
+
+        events[index] = { frame, command };
+        count.store(index + 1, std::memory_order_release);
+        return true;
+    }
+
+   /**
+      Find the index of the first event at or after @a frame.
+    */
+    uint32_t findFrame(const uint64_t frame) const noexcept
+    {
+        uint32_t low = 0;
+        uint32_t high = count.load(std::memory_order_acquire);
+
+        while (low < high)
+        {
+            const uint32_t mid = low + (high - low) / 2;
+
+            if (events[mid].frame < frame)
+                low = mid + 1;
+            else
+                high = mid;
+        }
+
+        return low;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // any thread
+
+    uint32_t getCount() const noexcept
+    {
+        return count.load(std::memory_order_acquire);
+    }
+
+    const Event& getEvent(const uint32_t index) const noexcept
+    {
+        return events[index];
+    }
+
+   /**
+      Index of the first event within the whole file, for timelines holding a window of it.
+    */
+    uint64_t getOffset() const noexcept
+    {
+        return offset;
+    }
+
+   /**
+      Whether more events follow in a later window, set before handing the timeline over to the realtime side.
+    */
+    bool isPartial() const noexcept
+    {
+        return partial;
+    }
+
+    void setPartial(const bool partial_) noexcept
+    {
+        partial = partial_;
+    }
+
+    // ----------------------------------------------------------------------------------------------------------------
+    // non-realtime
+
+    bool save(const char* const filename, const double sampleRate) const
+    {
+        FILE* const file = std::fopen(filename, "wb");
+        DISTRHO_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+        const uint32_t numEvents = getCount();
+
+        std::fwrite(kMagic, 1, sizeof(kMagic), file);
+        writeVarInt(file, kVersion);
+        writeVarInt(file, static_cast<uint64_t>(sampleRate + 0.5));
+        writeVarInt(file, numEvents);
+
+        uint64_t lastFrame = 0;
+
+        for (uint32_t i = 0; i < numEvents; ++i)
+        {
+            const Event& event(events[i]);
+            writeVarInt(file, event.frame - lastFrame);
+            // channel goes in the upper bits of the type, so files without channels read as channel 0
+            writeVarInt(file, event.command.type | event.command.channel << 8u);
+            writeVarInt(file, event.command.index);
+            writeVarInt(file, zigzag(event.command.value));
+            lastFrame = event.frame;
+        }
+
+        const bool ok = std::ferror(file) == 0;
+        return std::fclose(file) == 0 && ok;
+    }
+
+   /**
+      Load a timeline previously saved with save(), returns nullptr on failure or if it has more than @a maxCapacity events.
+    */
+    static Timeline* load(const char* const filename, const double sampleRate, const uint32_t maxCapacity)
+    {
+        Reader reader;
+
+        if (! reader.open(filename, sampleRate) || reader.getRemaining() > maxCapacity)
+            return nullptr;
+
+        Timeline* const timeline = new Timeline(static_cast<uint32_t>(reader.getRemaining()));
+
+        if (! reader.read(*timeline))
+        {
+            delete timeline;
+            return nullptr;
+        }
+
+        return timeline;
+    }
+
+   /**
+      Sequential reader of a file saved with save(), keeping only its position in memory.
+      Events are read into timelines as needed, so files of any length can be played in fixed-size windows.
+    */
+    class Reader
+    {
+    public:
+        Reader() noexcept = default;
+
+        ~Reader()
+        {
+            close();
+        }
+
+        bool open(const char* const filename, const double sampleRate)
+        {
+            close();
+
+            file = std::fopen(filename, "rb");
+            DISTRHO_SAFE_ASSERT_RETURN(file != nullptr, false);
+
+            char magic[sizeof(kMagic)];
+            uint64_t version, fileSampleRate;
+
+            if (std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+                && std::memcmp(magic, kMagic, sizeof(magic)) == 0
+                && readVarInt(file, version) && version == kVersion
+                && readVarInt(file, fileSampleRate) && fileSampleRate != 0
+                && readVarInt(file, remaining))
+            {
+                ratio = sampleRate / fileSampleRate;
+                fileFrame = 0;
+                return true;
+            }
+
+            close();
+            return false;
+        }
+
+        void close()
+        {
+            if (file != nullptr)
+            {
+                std::fclose(file);
+                file = nullptr;
+            }
+
+            remaining = 0;
+        }
+
+       /**
+          Number of events not read yet.
+        */
+        uint64_t getRemaining() const noexcept
+        {
+            return remaining;
+        }
+
+       /**
+          Read events into @a timeline until it is full or the file ends.
+          Returns false on a truncated or invalid file, which is closed in such case.
+        */
+        bool read(Timeline& timeline)
+        {
+            for (; remaining != 0 && timeline.getCount() != timeline.capacity; --remaining)
+            {
+                uint64_t delta, type, index, value;
+
+                if (! (readVarInt(file, delta) && readVarInt(file, type)
+                       && readVarInt(file, index) && readVarInt(file, value)))
+                {
+                    close();
+                    return false;
+                }
+
+                fileFrame += delta;
+
+                const Command command = {
+                    static_cast<uint16_t>(type & 0xff),
+                    static_cast<uint16_t>(index),
+                    unzigzag(value),
+                    static_cast<uint8_t>((type >> 8) & 0x0f),
+                };
+                timeline.append(static_cast<uint64_t>(fileFrame * ratio + 0.5), command);
+            }
+
+            return true;
+        }
+
+    private:
+        FILE* file = nullptr;
+        double ratio = 1.0;
+        uint64_t fileFrame = 0;
+        uint64_t remaining = 0;
+
+        DISTRHO_DECLARE_NON_COPYABLE(Reader)
+    };
+
+private:
+    static constexpr const char kMagic[4] = { 'A', 'M', 'C', 'T' };
+    static constexpr const uint64_t kVersion = 1;
+
+    Event* const events;
+    const uint32_t capacity;
+    const uint64_t offset;
+    bool partial = false;
+    std::atomic<uint32_t> count { 0 };
+
+    static uint64_t zigzag(const int32_t value) noexcept
+    {
+        return (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31);
+    }
+
+    static int32_t unzigzag(const uint64_t value) noexcept
+    {
+        return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+    }
+
+    static void writeVarInt(FILE* const file, uint64_t value)
+    {
+        uint8_t buf[10];
+        uint32_t size = 0;
+
+        do {
+            buf[size++] = (value & 0x7f) | (value > 0x7f ? 0x80 : 0);
+            value >>= 7;
+        } while (value != 0);
+
+        std::fwrite(buf, 1, size, file);
+    }
+
+    static bool readVarInt(FILE* const file, uint64_t& value)
+    {
+        value = 0;
+
+        for (uint32_t shift = 0; shift < 64; shift += 7)
+        {
+            const int c = std::fgetc(file);
+
+            if (c == EOF)
+                return false;
+
+            value |= static_cast<uint64_t>(c & 0x7f) << shift;
+
+            if ((c & 0x80) == 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    DISTRHO_DECLARE_NON_COPYABLE(Timeline)
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+END_NAMESPACE_DISTRHO
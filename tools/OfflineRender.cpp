@@ -0,0 +1,211 @@
+/*
+ * Anagram MIDI Control
+ * Copyright (C) 2025 Filipe Coelho <falktx@darkglass.com>
+ * SPDX-License-Identifier: ISC
+ */
+
+// Offline renderer of recorded timelines and command scripts into Standard MIDI Files.
+// The plugin runs exactly as it would in a host, block by block, so the file holds the same events it would send,
+// with event spacing, link rate and running status all applied.
+// Timelines are streamed a window at a time, so their length is not limited by memory.
+// Scripts can be given as text, compiled next to it as when loaded in the plugin, or already compiled.
+//
+// usage: anagram-render [options] <timeline|script> <output.mid>
+//   -r <rate>     sample rate, defaults to 48000
+//   -b <frames>   block size, defaults to 256
+//   -l <baud>     link rate, 0 for unlimited, defaults to 31250
+//   -s <ms>       event spacing, defaults to 1
+//   -rs           use running status in the file
+
+#include "src/DistrhoPlugin.cpp"
+#include "src/DistrhoUtils.cpp"
+
+#include "MidiFileWriter.hpp"
+#include "RunningStatusEncoder.hpp"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+USE_NAMESPACE_DISTRHO
+
+// --------------------------------------------------------------------------------------------------------------------
+
+struct Renderer {
+    MidiFileWriter writer;
+    RunningStatusEncoder encoder;
+    bool useRunningStatus = false;
+    uint64_t blockStart = 0;
+    uint64_t numEvents = 0;
+    bool failed = false;
+
+    static bool writeMidi(void* const ptr, const MidiEvent& event)
+    {
+        Renderer* const self = static_cast<Renderer*>(ptr);
+
+        // the plugin only generates short channel messages, anything else would need SMF escaping
+        if (event.size > MidiEvent::kDataSize || event.size == 0 || event.data[0] >= 0xF0)
+            return true;
+
+        bool ok;
+
+        if (self->useRunningStatus)
+        {
+            uint8_t data[MidiEvent::kDataSize];
+            const uint32_t size = self->encoder.encode(event.data, event.size, data);
+            ok = self->writer.write(self->blockStart + event.frame, data, size);
+        }
+        else
+        {
+            ok = self->writer.write(self->blockStart + event.frame, event.data, event.size);
+        }
+
+        if (! ok)
+            self->failed = true;
+
+        ++self->numEvents;
+        return true;
+    }
+
+    static bool requestParameterValueChange(void*, uint32_t, float)
+    {
+        return true;
+    }
+
+    static bool updateStateValue(void*, const char*, const char*)
+    {
+        return true;
+    }
+};
+
+// --------------------------------------------------------------------------------------------------------------------
+
+static int usage(const char* const name)
+{
+    std::fprintf(stderr, "usage: %s [-r rate] [-b frames] [-l baud] [-s ms] [-rs] <timeline|script> <output.mid>\n", name);
+    return 1;
+}
+
+// saved timelines start with their own magic, anything else is taken as a script
+static bool isTimelineFile(const char* const filename)
+{
+    FILE* const file = std::fopen(filename, "rb");
+
+    if (file == nullptr)
+        return false;
+
+    char magic[4];
+    const bool ok = std::fread(magic, 1, sizeof(magic), file) == sizeof(magic)
+                 && std::memcmp(magic, "AMCT", sizeof(magic)) == 0;
+
+    std::fclose(file);
+    return ok;
+}
+
+int main(int argc, char* argv[])
+{
+    double sampleRate = 48000.0;
+    uint32_t blockSize = 256;
+    float linkRate = 31250.0f;
+    float spacing = 1.0f;
+    bool runningStatus = false;
+    const char* input = nullptr;
+    const char* output = nullptr;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        const char* const arg = argv[i];
+
+        /**/ if (std::strcmp(arg, "-rs") == 0)
+            runningStatus = true;
+        else if (std::strcmp(arg, "-r") == 0 && i + 1 < argc)
+            sampleRate = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "-b") == 0 && i + 1 < argc)
+            blockSize = std::atoi(argv[++i]);
+        else if (std::strcmp(arg, "-l") == 0 && i + 1 < argc)
+            linkRate = std::atof(argv[++i]);
+        else if (std::strcmp(arg, "-s") == 0 && i + 1 < argc)
+            spacing = std::atof(argv[++i]);
+        else if (input == nullptr)
+            input = arg;
+        else if (output == nullptr)
+            output = arg;
+        else
+            return usage(argv[0]);
+    }
+
+    if (input == nullptr || output == nullptr || sampleRate < 100.0 || blockSize == 0 || blockSize > 65536)
+        return usage(argv[0]);
+
+    d_nextBufferSize = blockSize;
+    d_nextSampleRate = sampleRate;
+
+    Renderer renderer;
+    renderer.useRunningStatus = runningStatus;
+
+    if (! renderer.writer.open(output, sampleRate))
+    {
+        std::fprintf(stderr, "failed to open %s for writing\n", output);
+        return 1;
+    }
+
+    PluginExporter plugin(&renderer,
+                          Renderer::writeMidi,
+                          Renderer::requestParameterValueChange,
+                          Renderer::updateStateValue);
+
+    plugin.setParameterValue(kParamEventSpacing, spacing);
+    plugin.setParameterValue(kParamLinkRate, linkRate);
+    plugin.setParameterValue(kParamRunningStatus, runningStatus ? 1.0f : 0.0f);
+    plugin.setParameterValue(kParamTimelineSync, 0.0f);
+    plugin.activate();
+
+    // audio is not used, but the plugin still has audio ports
+    std::vector<float> buffers(blockSize * 4);
+    const float* inputs[2] = { buffers.data(), buffers.data() + blockSize };
+    float* outputs[2] = { buffers.data() + blockSize * 2, buffers.data() + blockSize * 3 };
+
+    const bool isTimeline = isTimelineFile(input);
+    const uint32_t eventsParam = isTimeline ? kParamTimelineEvents : kParamScriptEvents;
+    const uint32_t stateParam = isTimeline ? kParamTimelineState : kParamScriptState;
+
+    // the loaded file is picked up on the next block, which has nothing to send yet
+    plugin.setState(isTimeline ? "timeline_stream" : "script_load", input);
+    plugin.run(inputs, outputs, blockSize, nullptr, 0);
+
+    if (plugin.getParameterValue(eventsParam) < 0.5f)
+    {
+        std::fprintf(stderr, "failed to load %s or it has no events\n", input);
+        return 1;
+    }
+
+    // free-running playback starts at frame 0 and stops by itself once the last event is out
+    plugin.setState(isTimeline ? "timeline" : "script", "play");
+
+    do {
+        // moves the streamed window along once playback is past its first half, does nothing otherwise
+        if (isTimeline)
+            plugin.setState("timeline_stream", "");
+
+        // running status never carries over blocks in the plugin, match that in the file
+        renderer.encoder.reset();
+        plugin.run(inputs, outputs, blockSize, nullptr, 0);
+        renderer.blockStart += blockSize;
+    } while (plugin.getParameterValue(stateParam) > 0.5f && ! renderer.failed);
+
+    plugin.deactivate();
+
+    if (! renderer.writer.close() || renderer.failed)
+    {
+        std::fprintf(stderr, "failed to write %s\n", output);
+        return 1;
+    }
+
+    std::printf("%llu events, %.3f seconds\n",
+                static_cast<unsigned long long>(renderer.numEvents),
+                renderer.blockStart / sampleRate);
+    return 0;
+}
+
+// --------------------------------------------------------------------------------------------------------------------